@@ -0,0 +1,194 @@
+/*
+    This file is part of embedded_drivers.
+
+    embedded_drivers is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    embedded_drivers is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with embedded_drivers.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "embedded_drivers/lfsr.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace embedded_drivers {
+
+	namespace crc_detail {
+
+		// Reverses the lowest `bits` bits of `value`.
+		template <class T>
+		constexpr T Reflect(T value, unsigned int bits)
+		{
+			T result = 0;
+			for (unsigned int i = 0; i < bits; ++i, value >>= 1)
+				result = T(result << 1) | (value & 1);
+			return result;
+		}
+
+	} // end of namespace crc_detail
+
+	// Slice-by-SLICES lookup tables of a CRC, generated at compile time.
+	//
+	// A reflected CRC is a Galois LFSR with feedback Reflect(POLY), with
+	// the data XORed into the register, so mTable[0] is exactly the byte
+	// step table of Lfsr. A non-reflected CRC is its mirror image: it runs
+	// left-aligned in T and uses the same table with all bits reversed.
+	// mTable[k][v] is the register after byte v followed by k zero bytes.
+	template <class T, unsigned int WIDTH, T POLY, bool REFLECTED, unsigned int SLICES>
+	struct CrcSliceTable {
+		static const unsigned int cRegisterBits = 8 * sizeof(T);
+
+		T mTable[SLICES][256];
+
+		constexpr CrcSliceTable()
+			: mTable{}
+		{
+			constexpr T feedback = crc_detail::Reflect(POLY, WIDTH);
+			LfsrStepTable<T, feedback, 8> const steps{};
+
+			for (unsigned int v = 0; v < 256; ++v)
+				mTable[0][v] = REFLECTED ? steps.mFeedback[v]
+					: crc_detail::Reflect(steps.mFeedback[crc_detail::Reflect(v, 8)], cRegisterBits);
+			for (unsigned int k = 1; k < SLICES; ++k)
+				for (unsigned int v = 0; v < 256; ++v)
+					mTable[k][v] = ShiftByte(mTable[k-1][v]) ^ mTable[0][TopByte(mTable[k-1][v])];
+		}
+
+		// Register shifted by one byte towards the output end.
+		static constexpr T ShiftByte(T reg)
+		{
+			if (cRegisterBits <= 8)
+				return 0;
+			return REFLECTED ? T(reg >> 8) : T(reg << 8);
+		}
+
+		// Byte `i` of the register, counted from the output end.
+		static constexpr uint8_t TopByte(T reg, unsigned int i = 0)
+		{
+			return static_cast<uint8_t>(REFLECTED ? (reg >> (8 * i))
+					: (reg >> (cRegisterBits - 8 - 8 * i)));
+		}
+	};
+
+	// Implements a generic CRC of WIDTH bits with generator polynomial POLY,
+	// given in normal notation without the x^WIDTH term, like in the common
+	// CRC catalogues. REFLECTED means both input and output are reflected.
+	//
+	// Update() processes SLICES bytes per loop pass via tables generated at
+	// compile time, costing SLICES * 256 * sizeof(T) bytes. SLICES=1 is the
+	// classic byte-wise table, 4 or 8 are the slice-by-4/8 variants.
+	// UpdateBitwise() is the table-free reference.
+	template <class T, unsigned int WIDTH, T POLY, T INIT = 0, bool REFLECTED = false,
+		 T XOROUT = 0, unsigned int SLICES = 4>
+	class Crc {
+	public:
+		typedef T BaseType;
+		static const unsigned int cWidth = WIDTH;
+		static const unsigned int cSlices = SLICES;
+
+		static_assert(sizeof(T) * 8 >= WIDTH,
+			"BaseType is not large enough to represent the CRC.");
+		static_assert((WIDTH > 0) && (SLICES > 0),
+			"Width and number of slices must be larger than zero.");
+
+		Crc()
+		{
+			Reset();
+		}
+
+		void Reset(void)
+		{
+			mRegister = REFLECTED ? crc_detail::Reflect(INIT, WIDTH) : T(INIT << cAlign);
+		}
+
+		void Update(uint8_t const * data, size_t len)
+		{
+			T reg = mRegister;
+
+			for (; len >= SLICES; len -= SLICES, data += SLICES) {
+				T next = (cRegisterBits > 8 * SLICES) ? ShiftSlice(reg) : T(0);
+				for (unsigned int i = 0; i < SLICES; ++i) {
+					uint8_t index = data[i];
+					if (i < sizeof(T))
+						index ^= Table::TopByte(reg, i);
+					next ^= cTable.mTable[SLICES - 1 - i][index];
+				}
+				reg = next;
+			}
+			for (; len; --len, ++data)
+				reg = Table::ShiftByte(reg) ^ cTable.mTable[0][Table::TopByte(reg) ^ *data];
+
+			mRegister = reg;
+		}
+
+		void UpdateBitwise(uint8_t const * data, size_t len)
+		{
+			constexpr T reflected_poly = crc_detail::Reflect(POLY, WIDTH);
+			constexpr T aligned_poly = T(POLY << cAlign);
+			constexpr T top_bit = T(T(1) << (cRegisterBits - 1));
+
+			for (; len; --len, ++data) {
+				if (REFLECTED) {
+					mRegister ^= *data;
+					for (unsigned int b = 0; b < 8; ++b)
+						mRegister = (mRegister & 1) ? T((mRegister >> 1) ^ reflected_poly) : T(mRegister >> 1);
+				} else {
+					mRegister ^= T(T(*data) << (cRegisterBits - 8));
+					for (unsigned int b = 0; b < 8; ++b)
+						mRegister = (mRegister & top_bit) ? T(T(mRegister << 1) ^ aligned_poly) : T(mRegister << 1);
+				}
+			}
+		}
+
+		// Final CRC of all data since the last Reset().
+		T Get(void) const
+		{
+			T value = REFLECTED ? mRegister : T(mRegister >> cAlign);
+			return (value ^ XOROUT) & cMask;
+		}
+
+		static T Compute(uint8_t const * data, size_t len)
+		{
+			Crc crc;
+			crc.Update(data, len);
+			return crc.Get();
+		}
+
+	private:
+		static const unsigned int cRegisterBits = 8 * sizeof(T);
+		// non-reflected CRCs run left-aligned in T
+		static const unsigned int cAlign = REFLECTED ? 0 : cRegisterBits - WIDTH;
+		static constexpr T cMask = T(~T(0)) >> (cRegisterBits - WIDTH);
+
+		typedef CrcSliceTable<T, WIDTH, POLY, REFLECTED, SLICES> Table;
+		static constexpr Table cTable{};
+
+		T mRegister;
+
+		static T ShiftSlice(T reg)
+		{
+			if (cRegisterBits <= 8 * SLICES)
+				return 0;
+			const unsigned int shift = (8 * SLICES) % cRegisterBits;
+			return REFLECTED ? T(reg >> shift) : T(reg << shift);
+		}
+	};
+
+	// Several common CRCs, with their check value of the ASCII string "123456789".
+	typedef Crc<uint8_t,   8, 0x31>                                    Crc8Si7020;	// 0xa2
+	typedef Crc<uint16_t, 16, 0x1021, 0xffff>                          Crc16CcittFalse;	// 0x29b1
+	typedef Crc<uint16_t, 16, 0x8005, 0xffff, true>                    Crc16Modbus;	// 0x4b37
+	typedef Crc<uint32_t, 32, 0x04c11db7, 0xffffffff, true, 0xffffffff> Crc32;	// 0xcbf43926
+
+} // end of namespace embedded_drivers
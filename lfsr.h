@@ -19,14 +19,404 @@
 
 #ifdef LFSR_USE_LEGACY_C_HEADER
 # include <stdint.h>
+# include <stddef.h>
 # include <assert.h>
 #else
 # include <cstdint>
+# include <cstddef>
 # include <cassert>
 #endif
+#include <type_traits>
 
 namespace embedded_drivers {
 
+	// Compile-time arithmetic to check whether an LFSR has maximal period.
+	//
+	// A Galois LFSR of width n with Koopman-style FEEDBACK (bit i stands for
+	// x^(i+1), the +1 term is implicit) has maximal period 2^n-1 iff its
+	// feedback polynomial p(x) is primitive over GF(2), i.e. iff x has order
+	// exactly 2^n-1 modulo p(x): x^(2^n-1) == 1, and x^((2^n-1)/q) != 1 for
+	// every prime factor q of 2^n-1.
+	//
+	// Number arithmetic is done in an unsigned type U that holds 2^n-1,
+	// polynomial arithmetic in the register type T.
+	namespace lfsr_polynomial {
+
+		// (a + b) mod m, without overflowing U.
+		template <class U>
+		constexpr U AddMod(U a, U b, U m)
+		{
+			return (a >= m - b) ? U(a - (m - b)) : U(a + b);
+		}
+
+#ifdef __SIZEOF_INT128__
+		constexpr uint64_t MulMod(uint64_t a, uint64_t b, uint64_t m)
+		{
+			return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) % m);
+		}
+#endif
+
+		// (a * b) mod m, without overflowing U.
+		template <class U>
+		constexpr U MulMod(U a, U b, U m)
+		{
+			U result = 0;
+			for (a %= m; b; b >>= 1) {
+				if (b & 1)
+					result = AddMod(result, a, m);
+				a = AddMod(a, a, m);
+			}
+			return result;
+		}
+
+		template <class U>
+		constexpr U PowMod(U base, U exponent, U m)
+		{
+			U result = 1 % m;
+			for (base %= m; exponent; exponent >>= 1) {
+				if (exponent & 1)
+					result = MulMod(result, base, m);
+				base = MulMod(base, base, m);
+			}
+			return result;
+		}
+
+		template <class U>
+		constexpr U Gcd(U a, U b)
+		{
+			while (b) {
+				U t = a % b;
+				a = b;
+				b = t;
+			}
+			return a;
+		}
+
+		// Miller-Rabin test with the first 12 primes as bases.
+		// Deterministic for all n < 3.3*10^24, which covers U = uint64_t.
+		template <class U>
+		constexpr bool IsPrime(U n)
+		{
+			const unsigned int bases[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37 };
+
+			if (n < 2)
+				return false;
+			for (unsigned int b : bases)
+				if (0 == (n % b))
+					return n == b;
+
+			U d = n - 1;
+			unsigned int r = 0;
+			for (; 0 == (d & 1); d >>= 1)
+				++r;
+
+			for (unsigned int b : bases) {
+				U x = PowMod(U(b), d, n);
+				if ((x == 1) || (x == n - 1))
+					continue;
+				bool composite = true;
+				for (unsigned int i = 1; composite && (i < r); ++i) {
+					x = MulMod(x, x, n);
+					if (x == n - 1)
+						composite = false;
+				}
+				if (composite)
+					return false;
+			}
+			return true;
+		}
+
+		// Pollard's rho: returns a non-trivial factor of odd composite n.
+		template <class U>
+		constexpr U FindFactor(U n)
+		{
+			for (U c = 1; ; ++c) {
+				U x = 2;
+				U y = 2;
+				U d = 1;
+				while (d == 1) {
+					x = AddMod(MulMod(x, x, n), c, n);
+					y = AddMod(MulMod(y, y, n), c, n);
+					y = AddMod(MulMod(y, y, n), c, n);
+					d = Gcd(U(x > y ? x - y : y - x), n);
+				}
+				if (d != n)
+					return d;
+			}
+		}
+
+		// Distinct prime factors.
+		template <class U>
+		struct PrimeFactors {
+			static const unsigned int cMaxCount = 8 * sizeof(U);
+			static const unsigned int cTrialDivisionLimit = 1u << 16;
+
+			U mFactor[cMaxCount];
+			unsigned int mCount;
+
+			constexpr PrimeFactors()
+				: mFactor{}
+				, mCount(0)
+			{
+			}
+
+			// Prime factors of 2^width-1. It is split into
+			// (2^o-1) * (2^o+1) * (2^2o+1) * ... * (2^(width/2)+1), with o odd,
+			// so most parts fit into 64 bits and factor quickly.
+			// Prime factors of 2^e+1 are 1 mod 2^(k+1), where 2^k divides e,
+			// which keeps trial division of the wide parts short.
+			static constexpr PrimeFactors OfMersenne(unsigned int width)
+			{
+				PrimeFactors factors;
+				unsigned int odd = width;
+				while (0 == (odd & 1))
+					odd >>= 1;
+				factors.AddFactorsOf(U(~U(0)) >> (8 * sizeof(U) - odd));
+				for (unsigned int e = odd, step = 2; e < width; e *= 2, step *= 2)
+					factors.AddFactorsOf(U(U(1) << e) + 1, step);
+				return factors;
+			}
+
+			// Adds prime factors of n. All odd prime factors of n must be
+			// 1 mod `step`, which must be even.
+			constexpr void AddFactorsOf(U n, U step=2)
+			{
+				if (0 == (n % 2)) {
+					Add(2);
+					while (0 == (n % 2))
+						n /= 2;
+				}
+
+				// small factors by trial division
+				U d = 1 + step;
+				for (unsigned int k = 0; (k < cTrialDivisionLimit) && (d <= n / d); ++k, d += step) {
+					if (0 == (n % d)) {
+						Add(d);
+						while (0 == (n % d))
+							n /= d;
+					}
+				}
+				if (n == 1)
+					return;
+
+				// remaining large factors by Pollard's rho,
+				// in 64 bit arithmetic where possible
+				U composites[cMaxCount] = {};
+				unsigned int pending = 0;
+				composites[pending++] = n;
+				while (pending) {
+					U m = composites[--pending];
+					U f = 0;
+					if (m == U(uint64_t(m))) {
+						if (!IsPrime(uint64_t(m)))
+							f = FindFactor(uint64_t(m));
+					} else {
+						if (!IsPrime(m))
+							f = FindFactor(m);
+					}
+					if (f) {
+						composites[pending++] = f;
+						composites[pending++] = m / f;
+					} else {
+						Add(m);
+					}
+				}
+			}
+
+			constexpr void Add(U factor)
+			{
+				for (unsigned int i = 0; i < mCount; ++i)
+					if (mFactor[i] == factor)
+						return;
+				mFactor[mCount++] = factor;
+			}
+		};
+
+		// Arithmetic in GF(2)[x] / p(x), with p(x) = x^width + low(x).
+		template <class T>
+		struct PolynomialRing {
+			unsigned int mWidth;
+			T mMask;
+			T mLow;
+
+			// `feedback` in Koopman notation, see above.
+			constexpr PolynomialRing(unsigned int width, T feedback)
+				: mWidth(width)
+				, mMask((width >= 8 * sizeof(T)) ? T(~T(0)) : T((T(1) << width) - 1))
+				, mLow(T(((feedback << 1) | 1) & mMask))
+			{
+			}
+
+			constexpr T MulX(T a) const
+			{
+				bool carry = (a >> (mWidth - 1)) & 1;
+				a = T((a << 1) & mMask);
+				return carry ? T(a ^ mLow) : a;
+			}
+
+			constexpr T Mul(T a, T b) const
+			{
+				T result = 0;
+				for (; b; b >>= 1, a = MulX(a))
+					if (b & 1)
+						result ^= a;
+				return result;
+			}
+
+			// x^exponent
+			template <class U>
+			constexpr T PowX(U exponent) const
+			{
+				T result = 1;
+				T base = MulX(1);
+				for (; exponent; exponent >>= 1, base = Mul(base, base))
+					if (exponent & 1)
+						result = Mul(result, base);
+				return result;
+			}
+		};
+
+		// Returns true iff the LFSR with given width and Koopman-style
+		// feedback has the maximal period of 2^width-1.
+		template <class T, class U>
+		constexpr bool IsPrimitive(unsigned int width, T feedback)
+		{
+			if ((width == 0) || (width > 8 * sizeof(T)) || (width > 8 * sizeof(U)))
+				return false;
+			if (0 == ((feedback >> (width - 1)) & 1))
+				return false;	// degree of p(x) must equal width
+			if ((width < 8 * sizeof(T)) && (feedback >> width))
+				return false;
+
+			PolynomialRing<T> ring(width, feedback);
+			U const order = U(~U(0)) >> (8 * sizeof(U) - width);
+
+			if (ring.PowX(order) != 1)
+				return false;
+			if (order == 1)
+				return true;
+
+			PrimeFactors<U> factors = PrimeFactors<U>::OfMersenne(width);
+			for (unsigned int i = 0; i < factors.mCount; ++i)
+				if (ring.PowX(U(order / factors.mFactor[i])) == 1)
+					return false;
+			return true;
+		}
+
+		// Returns the smallest Koopman-style feedback with maximal period
+		// for the given width that is larger than `after`, or 0 if none.
+		template <class T, class U>
+		constexpr T FindMaximalFeedback(unsigned int width, T after=0)
+		{
+			T const top = T(T(1) << (width - 1));
+			T const last = T(top | (top - 1));
+			if (after >= last)
+				return 0;
+			T feedback = (after < top) ? top : T(after + 1);
+			for (; ; ++feedback) {
+				if (IsPrimitive<T, U>(width, feedback))
+					return feedback;
+				if (feedback == last)
+					return 0;
+			}
+		}
+
+	} // end of namespace lfsr_polynomial
+
+	// Lookup table that advances a Galois LFSR by STEP_BITS bits at once.
+	//
+	// Within STEP_BITS steps, only the lowest STEP_BITS bits of the register
+	// ever reach the feedback tap. So the register after STEP_BITS steps is
+	// (register >> STEP_BITS) ^ mFeedback[register & cMask], and the produced
+	// output bits are mOutput[register & cMask].
+	// The table is generated at compile time from FEEDBACK.
+	template <class T, T FEEDBACK, unsigned int STEP_BITS>
+	struct LfsrStepTable {
+		static_assert((STEP_BITS > 0) && (STEP_BITS <= 16),
+			"Step tables support 1 to 16 bits per step.");
+
+		typedef typename std::conditional<(STEP_BITS > 8), uint16_t, uint8_t>::type OutputType;
+		static const unsigned int cSize = 1u << STEP_BITS;
+		static const unsigned int cMask = cSize - 1;
+
+		T mFeedback[cSize];
+		OutputType mOutput[cSize];
+
+		constexpr LfsrStepTable()
+			: mFeedback{}
+			, mOutput{}
+		{
+			// Stepping is linear over GF(2): step each single-bit register
+			// value, then combine all other entries from those by XOR.
+			for (unsigned int bit = 0; bit < STEP_BITS; ++bit) {
+				T reg = static_cast<T>(1ULL << bit);
+				unsigned int output = 0;
+				for (unsigned int k = 0; k < STEP_BITS; ++k) {
+					bool feedback = reg & 1;
+					reg >>= 1;
+					output <<= 1;
+					if (feedback) {
+						reg ^= FEEDBACK;
+						output |= 1;
+					}
+				}
+				mFeedback[1u << bit] = reg;
+				mOutput[1u << bit] = static_cast<OutputType>(output);
+			}
+			for (unsigned int i = 1; i < cSize; ++i) {
+				unsigned int lowest = i & (~i + 1);
+				if (lowest != i) {
+					mFeedback[i] = mFeedback[i ^ lowest] ^ mFeedback[lowest];
+					mOutput[i] = mOutput[i ^ lowest] ^ mOutput[lowest];
+				}
+			}
+		}
+	};
+
+	// Powers M^(2^i) of the GF(2) transition matrix M of a Galois LFSR,
+	// for i < POWERS. Used to jump ahead in logarithmic time.
+	//
+	// A matrix is stored as its WIDTH columns, where column j is the
+	// register after stepping a register that only has bit j set.
+	// The table is generated at compile time from FEEDBACK.
+	template <class T, unsigned int WIDTH, T FEEDBACK, unsigned int POWERS>
+	struct LfsrJumpTable {
+		T mColumns[POWERS][WIDTH];
+
+		constexpr LfsrJumpTable()
+			: mColumns{}
+		{
+			// Stepping register bit j yields bit j-1, so for any power P of M:
+			// P e_(j-1) = P M e_j = M (P e_j). So each matrix follows from
+			// its last column by plain LFSR steps.
+			T column = Step(T(T(1) << (WIDTH - 1)));
+			for (unsigned int i = 0; i < POWERS; ++i) {
+				if (i > 0)
+					column = Apply(mColumns[i-1], mColumns[i-1][WIDTH-1]);
+				mColumns[i][WIDTH-1] = column;
+				for (unsigned int j = WIDTH - 1; j > 0; --j)
+					mColumns[i][j-1] = Step(mColumns[i][j]);
+			}
+		}
+
+		static constexpr T Step(T reg)
+		{
+			bool feedback = reg & 1;
+			reg >>= 1;
+			return feedback ? T(reg ^ FEEDBACK) : reg;
+		}
+
+		// Multiplies matrix `columns` with register state `reg`.
+		static constexpr T Apply(T const * columns, T reg)
+		{
+			T result = 0;
+			for (unsigned int j = 0; reg && (j < WIDTH); ++j, reg >>= 1)
+				if (reg & 1)
+					result ^= columns[j];
+			return result;
+		}
+	};
+
 	// Implements a generic linear feedback shift register that allows to shift
 	// additional random bits into the front to improve its randomness.
 	template <class T, unsigned int WIDTH, T INIT_VALUE, T FEEDBACK>
@@ -34,6 +424,23 @@ namespace embedded_drivers {
 	public:
 		typedef T BaseType;
 		static const unsigned int cWidth = WIDTH;
+		static constexpr BaseType cInitValue = INIT_VALUE;
+		static constexpr BaseType cFeedback = FEEDBACK;
+
+		// Unsigned type able to hold the maximal period.
+		typedef typename std::conditional<(sizeof(BaseType) > sizeof(uint64_t)),
+				BaseType, uint64_t>::type CountType;
+
+		// Period of the LFSR, given that FEEDBACK yields a maximal period.
+		static constexpr CountType cMaximalPeriod =
+			static_cast<CountType>(~CountType(0)) >> (8 * sizeof(CountType) - cWidth);
+
+		// Whether FEEDBACK yields the maximal period, i.e. is a primitive
+		// polynomial over GF(2). Can be evaluated at compile time.
+		static constexpr bool IsMaximal(void)
+		{
+			return lfsr_polynomial::IsPrimitive<BaseType, CountType>(cWidth, FEEDBACK);
+		}
 
 		Lfsr(BaseType initial_state=INIT_VALUE)
 		{
@@ -63,6 +470,87 @@ namespace embedded_drivers {
 			return output;
 		}
 
+		// Same as Iterate(), but advances STEP_BITS (usually 8 or 16) bits
+		// per loop pass via a lookup table generated at compile time.
+		// The output is bit-identical to Iterate().
+		// The table costs (sizeof(BaseType)+STEP_BITS/8) << STEP_BITS bytes.
+		template <unsigned int STEP_BITS = 8>
+		BaseType IterateTable(unsigned count=1, BaseType input=0)
+		{
+			return IterateWide<BaseType, STEP_BITS>(count, input);
+		}
+
+		// Same as IterateTable(), but returns up to 8*sizeof(OutputType) bits,
+		// which may be more than one BaseType holds. E.g. IterateWide<uint64_t>()
+		// of a 32 bit LFSR equals two calls to Iterate(32), MSB first.
+		template <class OutputType, unsigned int STEP_BITS = 8>
+		OutputType IterateWide(unsigned count=8*sizeof(OutputType), BaseType input=0)
+		{
+			assert(count <= (8 * sizeof(OutputType)));
+
+			typedef LfsrStepTable<BaseType, FEEDBACK, STEP_BITS> Table;
+
+			OutputType output = 0;
+			mShiftReg ^= input;
+			for (; count >= STEP_BITS; count -= STEP_BITS) {
+				unsigned int index = mShiftReg & Table::cMask;
+				mShiftReg = (mShiftReg >> STEP_BITS) ^ cStepTable<STEP_BITS>.mFeedback[index];
+				output = (output << STEP_BITS) | cStepTable<STEP_BITS>.mOutput[index];
+			}
+			while (count) {
+				unsigned int bits = (count < 8 * sizeof(BaseType)) ? count : 8 * sizeof(BaseType);
+				output = (output << bits) | Iterate(bits);
+				count -= bits;
+			}
+			return output;
+		}
+
+		// Fills `words` words of output with 8*sizeof(OutputType) bits each.
+		// Same output as `words` calls to IterateWide<OutputType>().
+		template <class OutputType>
+		void IterateWords(OutputType * output, size_t words)
+		{
+			for (size_t i = 0; i < words; ++i)
+				output[i] = IterateWide<OutputType>();
+		}
+
+		// Fills `len` bytes with output bits, 8 bits per byte, MSB first.
+		// Same output as `len` calls to Iterate(8).
+		void Fill(uint8_t * buffer, size_t len)
+		{
+			IterateWords(buffer, len);
+		}
+
+		// Advances the register by `steps` iterations in O(log steps),
+		// discarding the output. Same as `steps` calls to Iterate().
+		// The jump table costs 8*sizeof(CountType) * cWidth * sizeof(BaseType) bytes.
+		void Skip(CountType steps)
+		{
+			for (unsigned int i = 0; steps; ++i, steps >>= 1)
+				if (steps & 1)
+					mShiftReg = JumpTable::Apply(cJumpTable.mColumns[i], mShiftReg);
+		}
+
+		// Splits the maximal period into `substreams` non-overlapping
+		// slices of equal length and advances to the start of the next one.
+		void Jump(CountType substreams)
+		{
+			assert(substreams > 0);
+			Skip(cMaximalPeriod / substreams);
+		}
+
+		// Returns an LFSR positioned at the start of slice `index` out of
+		// `substreams` equal slices of the period that starts at
+		// `initial_state`. E.g. each of K worker threads can own one slice.
+		static Lfsr Substream(CountType index, CountType substreams,
+				BaseType initial_state=INIT_VALUE)
+		{
+			assert(index < substreams);
+			Lfsr lfsr(initial_state);
+			lfsr.Skip(index * (cMaximalPeriod / substreams));
+			return lfsr;
+		}
+
 		BaseType GetRegisterState(void)
 		{
 			return mShiftReg;
@@ -70,6 +558,200 @@ namespace embedded_drivers {
 
 	private:
 		BaseType mShiftReg;
+
+		typedef LfsrJumpTable<BaseType, WIDTH, FEEDBACK, 8 * sizeof(CountType)> JumpTable;
+		static constexpr JumpTable cJumpTable{};
+
+		template <unsigned int STEP_BITS>
+		static constexpr LfsrStepTable<BaseType, FEEDBACK, STEP_BITS> cStepTable{};
+	};
+
+	// Runs cLanes independent instances of an Lfsr in parallel, bit-sliced
+	// across uint64_t: slice j holds register bit j of all lanes, so one step
+	// of all lanes costs one XOR per feedback tap.
+	// Lane k starts at LFSR::Substream(k, cLanes), so lanes do not overlap
+	// within one period.
+	// Only suited for bulk output; there is no way to shift input into lanes.
+	template <class LFSR>
+	class LfsrBitSliced {
+	public:
+		typedef typename LFSR::BaseType BaseType;
+		static const unsigned int cLanes = 64;
+		static const unsigned int cWidth = LFSR::cWidth;
+
+		LfsrBitSliced(BaseType initial_state=LFSR::cInitValue)
+			: mSlices{}
+			, mHead(0)
+		{
+			static_assert(LFSR::cMaximalPeriod >= cLanes,
+				"Period is too short to split into lanes.");
+			for (unsigned int lane = 0; lane < cLanes; ++lane) {
+				BaseType reg = LFSR::Substream(lane, cLanes, initial_state).GetRegisterState();
+				for (unsigned int j = 0; j < cWidth; ++j)
+					if ((reg >> j) & 1)
+						mSlices[j] |= uint64_t(1) << lane;
+			}
+		}
+
+		// Steps all lanes once. Bit k of the result is the output bit of lane k.
+		uint64_t Iterate(void)
+		{
+			return Step(mSlices, mHead);
+		}
+
+		// Fills `len` bytes with output, 8 bytes per step of all lanes.
+		// Bit k of each little-endian 64-bit word is the output of lane k.
+		// A tail of `len % 8` bytes still takes a full step and drops the
+		// rest of that word, so only calls with multiples of 8 bytes
+		// concatenate to the same stream as one larger call.
+		void Fill(uint8_t * buffer, size_t len)
+		{
+			// work on a local copy, as stores to `buffer` may alias the members
+			uint64_t slices[cWidth];
+			unsigned int head = mHead;
+			for (unsigned int j = 0; j < cWidth; ++j)
+				slices[j] = mSlices[j];
+
+			for (; len >= 8; len -= 8, buffer += 8) {
+				uint64_t word = Step(slices, head);
+				for (unsigned int b = 0; b < 8; ++b)
+					buffer[b] = static_cast<uint8_t>(word >> (8 * b));
+			}
+			if (len) {
+				uint64_t word = Step(slices, head);
+				for (unsigned int b = 0; b < len; ++b)
+					buffer[b] = static_cast<uint8_t>(word >> (8 * b));
+			}
+
+			for (unsigned int j = 0; j < cWidth; ++j)
+				mSlices[j] = slices[j];
+			mHead = head;
+		}
+
+	private:
+		// Register bits that receive feedback.
+		struct Taps {
+			unsigned int mCount;
+			unsigned int mPosition[cWidth];
+
+			constexpr Taps()
+				: mCount(0)
+				, mPosition{}
+			{
+				for (unsigned int j = 0; j < cWidth; ++j)
+					if ((LFSR::cFeedback >> j) & 1)
+						mPosition[mCount++] = j;
+			}
+		};
+		static constexpr Taps cTaps{};
+
+		static uint64_t Step(uint64_t * slices, unsigned int & head)
+		{
+			uint64_t feedback = slices[head];
+			slices[head] = 0;
+			if (++head == cWidth)
+				head = 0;
+			for (unsigned int t = 0; t < cTaps.mCount; ++t) {
+				unsigned int slice = head + cTaps.mPosition[t];
+				if (slice >= cWidth)
+					slice -= cWidth;
+				slices[slice] ^= feedback;
+			}
+			return feedback;
+		}
+
+		// Ring of slices: register bit j of all lanes is at mSlices[(mHead + j) % cWidth].
+		uint64_t mSlices[cWidth];
+		unsigned int mHead;
+	};
+
+	// Adapts an Lfsr to the UniformRandomBitGenerator requirements, so it can
+	// be passed to <random> distributions, std::shuffle() etc.
+	// Output words are generated in bulk into a buffer of BUFFER_WORDS words.
+	// Also provides bounded integers and floating point numbers directly,
+	// which are cheaper than the generic <random> distributions.
+	template <class LFSR, class ResultType = uint32_t, unsigned int BUFFER_WORDS = 16>
+	class LfsrRandomBitGenerator {
+	public:
+		static_assert(std::is_same<ResultType, uint32_t>::value
+				|| std::is_same<ResultType, uint64_t>::value,
+			"ResultType must be uint32_t or uint64_t.");
+		static_assert(BUFFER_WORDS > 0, "Buffer must hold at least one word.");
+
+		typedef ResultType result_type;
+
+		LfsrRandomBitGenerator(typename LFSR::BaseType initial_state=LFSR::cInitValue)
+			: mLfsr(initial_state)
+			, mBuffer{}
+			, mNext(BUFFER_WORDS)
+		{
+		}
+
+		static constexpr result_type min(void) { return 0; }
+		static constexpr result_type max(void) { return static_cast<result_type>(~result_type(0)); }
+
+		result_type operator()(void)
+		{
+			if (mNext == BUFFER_WORDS) {
+				mLfsr.IterateWords(mBuffer, BUFFER_WORDS);
+				mNext = 0;
+			}
+			return mBuffer[mNext++];
+		}
+
+		// Uniformly distributed integer in [0, range), range > 0.
+		// Uses Lemire's multiply-shift method, which only needs a division
+		// in the rare case that a sample has to be rejected.
+		uint32_t Bounded(uint32_t range)
+		{
+			assert(range > 0);
+
+			uint64_t product = uint64_t(Next32()) * range;
+			uint32_t low = static_cast<uint32_t>(product);
+			if (low < range) {
+				uint32_t threshold = static_cast<uint32_t>(-range) % range;
+				while (low < threshold) {
+					product = uint64_t(Next32()) * range;
+					low = static_cast<uint32_t>(product);
+				}
+			}
+			return static_cast<uint32_t>(product >> 32);
+		}
+
+		// Uniformly distributed in [0, 1), with 24 random bits.
+		float Float(void)
+		{
+			return (Next32() >> 8) * (1.0f / 16777216.0f);
+		}
+
+		// Uniformly distributed in [0, 1), with 53 random bits.
+		double Double(void)
+		{
+			return (Next64() >> 11) * (1.0 / 9007199254740992.0);
+		}
+
+		LFSR & GetLfsr(void)
+		{
+			return mLfsr;
+		}
+
+	private:
+		LFSR mLfsr;
+		result_type mBuffer[BUFFER_WORDS];
+		unsigned int mNext;
+
+		uint32_t Next32(void)
+		{
+			return static_cast<uint32_t>((*this)() >> (8 * sizeof(result_type) - 32));
+		}
+
+		uint64_t Next64(void)
+		{
+			if constexpr (sizeof(result_type) >= sizeof(uint64_t))
+				return (*this)();
+			uint64_t high = (*this)();
+			return (high << 32) | (*this)();
+		}
 	};
 
 	// Several default LFSR implementations with maximal period, as per http://users.ece.cmu.edu/~koopman/lfsr/
@@ -84,5 +766,26 @@ namespace embedded_drivers {
 	typedef Lfsr<uint32_t, 18, 0b1,    0x2001F>       LfsrDefault18;
 	typedef Lfsr<uint32_t, 24, 0b1,    0x80000D>      LfsrDefault24;
 	typedef Lfsr<uint32_t, 32, 0b1,    0x80000057LLU> LfsrDefault32;
+	typedef Lfsr<uint64_t, 64, 0b1,    0x800000000000000DLLU> LfsrDefault64;
+#ifdef __SIZEOF_INT128__
+	// x^128 + x^7 + x^2 + x + 1
+	typedef Lfsr<unsigned __int128, 128, 0b1,
+		(static_cast<unsigned __int128>(1) << 127) | 0x43> LfsrDefault128;
+#endif
+
+	static_assert(LfsrDefault4::IsMaximal(),  "LfsrDefault4 does not have maximal period.");
+	static_assert(LfsrDefault8::IsMaximal(),  "LfsrDefault8 does not have maximal period.");
+	static_assert(LfsrDefault9::IsMaximal(),  "LfsrDefault9 does not have maximal period.");
+	static_assert(LfsrDefault10::IsMaximal(), "LfsrDefault10 does not have maximal period.");
+	static_assert(LfsrDefault15::IsMaximal(), "LfsrDefault15 does not have maximal period.");
+	static_assert(LfsrFibonacci::IsMaximal(), "LfsrFibonacci does not have maximal period.");
+	static_assert(LfsrDefault16::IsMaximal(), "LfsrDefault16 does not have maximal period.");
+	static_assert(LfsrDefault17::IsMaximal(), "LfsrDefault17 does not have maximal period.");
+	static_assert(LfsrDefault18::IsMaximal(), "LfsrDefault18 does not have maximal period.");
+	static_assert(LfsrDefault24::IsMaximal(), "LfsrDefault24 does not have maximal period.");
+	static_assert(LfsrDefault32::IsMaximal(), "LfsrDefault32 does not have maximal period.");
+	static_assert(LfsrDefault64::IsMaximal(), "LfsrDefault64 does not have maximal period.");
+	// LfsrDefault128 is checked in tests/test_lfsr.cpp only,
+	// as evaluating IsMaximal() costs about a second of compile time.
 
 } // end of namespace embedded_drivers
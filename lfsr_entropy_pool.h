@@ -0,0 +1,160 @@
+/*
+    This file is part of embedded_drivers.
+
+    embedded_drivers is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    embedded_drivers is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with embedded_drivers.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "embedded_drivers/lfsr.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace embedded_drivers {
+
+	// Lock-free pool that folds true-random bytes into an Lfsr.
+	//
+	// A single producer, e.g. the interrupt handler of a hardware RNG, pushes
+	// raw entropy bytes into a single-producer/single-consumer ring.
+	// The pending bytes are folded into the LFSR in batches of one LFSR width,
+	// via the input path of Lfsr::Iterate().
+	// The LFSR state is kept in an atomic and only ever replaced by an atomic
+	// compare-and-swap, so random bits can be taken concurrently from several
+	// threads, and no lock is held while the producer interrupts.
+	template <class LFSR, unsigned int RING_SIZE = 32>
+	class LfsrEntropyPool {
+	public:
+		typedef typename LFSR::BaseType BaseType;
+
+		// Number of entropy bytes folded in per LFSR update.
+		static const unsigned int cBatchBytes = (LFSR::cWidth >= 8) ? (LFSR::cWidth / 8) : 1;
+
+		static_assert((RING_SIZE & (RING_SIZE - 1)) == 0,
+			"RING_SIZE must be a power of two.");
+		static_assert(RING_SIZE >= cBatchBytes,
+			"RING_SIZE must hold at least one batch.");
+		static_assert(std::atomic<BaseType>::is_always_lock_free,
+			"LFSR state must be lock-free atomic.");
+
+		LfsrEntropyPool(BaseType initial_state=LFSR::cInitValue)
+			: mState(initial_state)
+			, mRing{}
+			, mHead(0)
+			, mTail(0)
+			, mDropped(0)
+		{
+			mFolding.clear();
+		}
+
+		// Producer side, safe to call from an interrupt handler.
+		// Returns false and drops the byte if the ring is full.
+		bool Push(uint8_t entropy)
+		{
+			unsigned int head = mHead.load(std::memory_order_relaxed);
+			if (head - mTail.load(std::memory_order_acquire) >= RING_SIZE) {
+				mDropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			mRing[head % RING_SIZE] = entropy;
+			mHead.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Folds all pending entropy into the LFSR.
+		// Returns immediately if another context is already folding.
+		void Reseed(void)
+		{
+			Fold(1);
+		}
+
+		// Returns `count` pseudo-random bits, like Lfsr::Iterate().
+		// Folds pending entropy first, if at least one batch is pending.
+		BaseType Iterate(unsigned count=1)
+		{
+			Fold(cBatchBytes);
+
+			BaseType state = mState.load(std::memory_order_relaxed);
+			BaseType output;
+			LFSR lfsr;
+			do {
+				lfsr = LFSR(state);
+				output = lfsr.IterateTable(count);
+			} while (!mState.compare_exchange_weak(state, lfsr.GetRegisterState(),
+						std::memory_order_relaxed));
+			return output;
+		}
+
+		BaseType GetRegisterState(void)
+		{
+			return mState.load(std::memory_order_relaxed);
+		}
+
+		// Number of entropy bytes waiting to be folded in.
+		unsigned int Pending(void)
+		{
+			return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_relaxed);
+		}
+
+		// Number of entropy bytes dropped because the ring was full.
+		uint32_t Dropped(void)
+		{
+			return mDropped.load(std::memory_order_relaxed);
+		}
+
+	private:
+		std::atomic<BaseType> mState;
+
+		uint8_t mRing[RING_SIZE];
+		std::atomic<unsigned int> mHead;
+		std::atomic<unsigned int> mTail;
+		std::atomic<uint32_t> mDropped;
+
+		// Held by the single consumer of the ring.
+		std::atomic_flag mFolding;
+
+		// Folds pending batches while at least `min_bytes` are pending.
+		void Fold(unsigned int min_bytes)
+		{
+			if (Pending() < min_bytes)
+				return;
+			if (mFolding.test_and_set(std::memory_order_acquire))
+				return;
+
+			unsigned int tail = mTail.load(std::memory_order_relaxed);
+			unsigned int pending;
+			while ((pending = mHead.load(std::memory_order_acquire) - tail) >= min_bytes) {
+				unsigned int bytes = (pending < cBatchBytes) ? pending : cBatchBytes;
+				BaseType input = 0;
+				for (unsigned int i = 0; i < bytes; ++i, ++tail)
+					input = BaseType(input << 8) | mRing[tail % RING_SIZE];
+				mTail.store(tail, std::memory_order_release);
+				input &= static_cast<BaseType>(LFSR::cMaximalPeriod);
+
+				BaseType state = mState.load(std::memory_order_relaxed);
+				LFSR lfsr;
+				do {
+					// an all-zero register would never leave zero again
+					lfsr = LFSR(state);
+					lfsr.IterateTable(8 * bytes, (state ^ input) ? input : 0);
+				} while (!mState.compare_exchange_weak(state, lfsr.GetRegisterState(),
+							std::memory_order_relaxed));
+			}
+
+			mFolding.clear(std::memory_order_release);
+		}
+	};
+
+} // end of namespace embedded_drivers
@@ -26,6 +26,11 @@ namespace embedded_drivers {
 	Mpu9250SpiSensor::Mpu9250SpiSensor(void * spiContext, SpiXferCallback spiXfer)
 		: mSpiContext(spiContext)
 		, mSpiXfer(spiXfer)
+		, mFifoEn(0)
+		, mFifoFrameSize(0)
+		, mSamplePeriodNsecs(0)
+		, mFifoFrames(0)
+		, mFifoUsecs(0)
 	{
 		Reset();
 	}
@@ -229,6 +234,153 @@ namespace embedded_drivers {
 		return true;
 	}
 
+	bool Mpu9250SpiSensor::SetSampleRate(uint8_t divider)
+	{
+		/* the divider only applies to the 1kHz internal rate with DLPF */
+		if(!ChangeReg8(regGyroConfig, ~regGyroConfig_FChoice_B(3), 0))
+			return false;
+
+		if(!ChangeReg8(regConfig, ~regConfig_Dlpf_Cfg(7), regConfig_Dlpf_Cfg(1)))
+			return false;
+
+		return SetReg8(regSmplrtDiv, divider);
+	}
+
+	bool Mpu9250SpiSensor::FifoEnable(uint8_t fifoEn)
+	{
+		/* samples from I2C slaves are not supported */
+		fifoEn &= regFifoEn_Temp | regFifoEn_Gyro | regFifoEn_Accel;
+
+		uint8_t divider, config, gyroConfig;
+		if(!GetReg8(regSmplrtDiv, &divider)
+				|| !GetReg8(regConfig, &config)
+				|| !GetReg8(regGyroConfig, &gyroConfig))
+			return false;
+
+		/* MPU9250 Register Map v1.6, Section 4.5 and 4.6 */
+		uint32_t periodNsecs;
+		unsigned dlpf = config & regConfig_Dlpf_Cfg(7);
+		if(gyroConfig & regGyroConfig_FChoice_B(3))
+			periodNsecs = 1000000000 / 32000;
+		else if(dlpf == 0 || dlpf == 7)
+			periodNsecs = 1000000000 / 8000;
+		else
+			periodNsecs = 1000000 * (1 + divider);
+
+		unsigned frameSize = 0;
+		if(fifoEn & regFifoEn_Accel)
+			frameSize += 6;
+		if(fifoEn & regFifoEn_Temp)
+			frameSize += 2;
+		for(unsigned axis = regFifoEn_Gyro_Z; axis <= regFifoEn_Gyro_X; axis <<= 1)
+			if(fifoEn & axis)
+				frameSize += 2;
+
+		if(!FifoDisable())
+			return false;
+
+		if(!fifoEn)
+			return true;
+
+		/* replace the oldest data when full, so overflows are flagged */
+		if(!ChangeReg8(regConfig, ~regConfig_Fifo_Mode, 0))
+			return false;
+
+		if(!SetReg8(regFifoEn, fifoEn))
+			return false;
+
+		if(!ChangeReg8(regUserCtrl, 0xff, regUserCtrl_Fifo_En | regUserCtrl_Fifo_Rst))
+			return false;
+
+		/* only now the sensor collects frames of this layout */
+		mSamplePeriodNsecs = periodNsecs;
+		mFifoFrameSize = frameSize;
+		mFifoEn = fifoEn;
+
+		/* drop an overflow flagged before */
+		uint8_t status;
+		return GetReg8(regIntStatus, &status);
+	}
+
+	bool Mpu9250SpiSensor::FifoDisable(void)
+	{
+		if(!ChangeReg8(regUserCtrl, ~regUserCtrl_Fifo_En, 0))
+			return false;
+		mFifoEn = 0;
+		mFifoFrameSize = 0;
+		mFifoFrames = 0;
+
+		if(!SetReg8(regFifoEn, 0))
+			return false;
+
+		return FifoReset();
+	}
+
+	bool Mpu9250SpiSensor::FifoRead(uint8_t *buffer, size_t size, unsigned *frames, bool *overflow, uint32_t nowUsecs)
+	{
+		*frames = 0;
+		*overflow = false;
+		mFifoFrames = 0;
+		mFifoUsecs = nowUsecs;
+
+		if(!mFifoFrameSize)
+			return false;
+
+		unsigned count;
+		if(!FifoCount(&count))
+			return false;
+
+		unsigned available = count / mFifoFrameSize;
+		unsigned n = available;
+		if(size < 1 + n * mFifoFrameSize)
+			n = size ? (size - 1) / mFifoFrameSize : 0;
+
+		if(n) {
+			uint8_t header = SpiTransferHeader(true, regFifoRW);
+			if(!mSpiXfer(mSpiContext, &header, 1, buffer, 1 + n * mFifoFrameSize))
+				return false;
+		}
+
+		/* checked after the transfer, as an overflow while reading
+		 * would also have moved the frames read */
+		uint8_t status;
+		if(!GetReg8(regIntStatus, &status))
+			return false;
+		if(status & regIntStatus_FIFO_Overflow) {
+			*overflow = true;
+			return FifoReset();
+		}
+
+		*frames = n;
+		mFifoFrames = available;
+		return true;
+	}
+
+	void Mpu9250SpiSensor::FifoUnpack(uint8_t const *buffer, unsigned index, FifoSample *sample)
+	{
+		uint8_t const *p = buffer + 1 + index * mFifoFrameSize;
+		memset(sample, 0, sizeof(*sample));
+
+		unsigned age = mFifoFrames - 1 - index;
+		sample->timestampUsecs = mFifoUsecs - uint32_t(uint64_t(age) * mSamplePeriodNsecs / 1000);
+
+		/* frames hold the selected registers in address order, big endian */
+		if(mFifoEn & regFifoEn_Accel) {
+			for(unsigned i = 0; i < 3; ++i, p += 2)
+				sample->accel[i] = int16_t((p[0] << 8) | p[1]);
+		}
+		if(mFifoEn & regFifoEn_Temp) {
+			sample->temp = int16_t((p[0] << 8) | p[1]);
+			p += 2;
+		}
+		for(unsigned i = 0; i < 3; ++i) {
+			if(mFifoEn & (regFifoEn_Gyro_X >> i)) {
+				sample->gyro[i] = int16_t((p[0] << 8) | p[1]);
+				p += 2;
+			}
+		}
+	}
+
 	void Mpu9250SpiSensor::PrintAllRegisters(void)
 	{
 		for(uint8_t reg=0; reg<=0x7e; ++reg) {
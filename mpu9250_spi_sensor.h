@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 namespace embedded_drivers {
@@ -63,8 +64,81 @@ namespace embedded_drivers {
 		static uint8_t G2WomThr(float g)
 		{ return uint8_t(g*(1000/4)); }
 
+		/*
+		 * FIFO burst streaming: the sensor collects samples at the
+		 * sample rate in its 512 byte FIFO, and FifoRead() fetches
+		 * all whole frames of them with one SPI transfer.
+		 */
+
+		struct FifoSample {
+			uint32_t timestampUsecs;
+			int16_t accel[3];
+			int16_t temp;
+			int16_t gyro[3];
+		};
+
+		static const unsigned cFifoSize = 512;
+
+		/* sample rate 1kHz/(1+divider), with gyro DLPF at 184Hz */
+		bool SetSampleRate(uint8_t divider);
+
+		/* resets the FIFO and starts collecting the data selected by
+		 * regFifoEn_* bits of `fifoEn`, e.g. regFifoEn_Accel|regFifoEn_Gyro */
+		bool FifoEnable(uint8_t fifoEn);
+
+		bool FifoDisable(void);
+
+		bool FifoReset(void)
+		{ return ChangeReg8(regUserCtrl, 0xff, regUserCtrl_Fifo_Rst); }
+
+		/* bytes of one sample in the FIFO */
+		unsigned FifoFrameSize(void)
+		{ return mFifoFrameSize; }
+
+		/* time between samples, as configured when enabling the FIFO */
+		uint32_t SamplePeriodNsecs(void)
+		{ return mSamplePeriodNsecs; }
+
+		bool FifoCount(unsigned *bytes)
+		{
+			uint16_t count;
+			if(!Access1Reg16(regFifoCount, true, &count))
+				return false;
+			*bytes = count & 0x1fff;
+			return true;
+		}
+
+		/*
+		 * Reads as many whole frames as are in the FIFO and fit into
+		 * `size`-1 bytes of `buffer`, with one SPI transfer. The frames
+		 * start at buffer[1], buffer[0] is clocked in with the command.
+		 * The transfer has tx_size 1, the callback must clock in rx_size
+		 * bytes anyway, as e.g. nrfx SPIM does.
+		 * On overflow the oldest samples were lost and frames are no
+		 * longer aligned, so the FIFO is reset, *frames is 0 and
+		 * *overflow set. Reading regIntStatus elsewhere, e.g. with
+		 * AcknowledgeInterrupt(), clears the flag before it is seen here.
+		 * `nowUsecs` is taken as the time of the newest frame in the
+		 * FIFO, which may be one left there for want of room.
+		 */
+		bool FifoRead(uint8_t *buffer, size_t size, unsigned *frames, bool *overflow, uint32_t nowUsecs);
+
+		/* unpacks frame `index` of the last FifoRead(), timestamped
+		 * back from the newest frame by the sample period */
+		void FifoUnpack(uint8_t const *buffer, unsigned index, FifoSample *sample);
+
 		void PrintAllRegisters(void);
 
+		unsigned const regSmplrtDiv = 0x19;
+
+		unsigned const regConfig = 0x1a;
+		unsigned const regConfig_Fifo_Mode = (1<<6);
+		static unsigned regConfig_Dlpf_Cfg(unsigned x) { return ((x&7)<<0); }
+
+		unsigned const regGyroConfig = 0x1b;
+		static unsigned regGyroConfig_Gyro_Fs_Sel(unsigned x) { return ((x&3)<<3); }
+		static unsigned regGyroConfig_FChoice_B(unsigned x) { return ((x&3)<<0); }
+
 		unsigned const regAccelConfig = 0x1c;
 		unsigned const regAccelConfig_Ax_St_En = (1<<15);
 		unsigned const regAccelConfig_Ay_St_En = (1<<14);
@@ -90,6 +164,14 @@ namespace embedded_drivers {
 
 		unsigned const regWomThr = 0x1f;
 
+		unsigned const regFifoEn = 0x23;
+		unsigned const regFifoEn_Temp = (1<<7);
+		unsigned const regFifoEn_Gyro_X = (1<<6);
+		unsigned const regFifoEn_Gyro_Y = (1<<5);
+		unsigned const regFifoEn_Gyro_Z = (1<<4);
+		unsigned const regFifoEn_Gyro = (7<<4);
+		unsigned const regFifoEn_Accel = (1<<3);
+
 		unsigned const regIntPinCfg = 0x37;
 		unsigned const regIntPinCfg_ActiveLow = (1<<7);
 		unsigned const regIntPinCfg_OpenDrain = (1<<6);
@@ -121,6 +203,14 @@ namespace embedded_drivers {
 		unsigned const regMotDetectCtrl_Accel_Intel_En = (1<<7);
 		unsigned const regMotDetectCtrl_Accel_Intel_Mode = (1<<6);
 
+		unsigned const regUserCtrl = 0x6a;
+		unsigned const regUserCtrl_Fifo_En = (1<<6);
+		unsigned const regUserCtrl_I2c_Mst_En = (1<<5);
+		unsigned const regUserCtrl_I2c_If_Dis = (1<<4);
+		unsigned const regUserCtrl_Fifo_Rst = (1<<2);
+		unsigned const regUserCtrl_I2c_Mst_Rst = (1<<1);
+		unsigned const regUserCtrl_Sig_Cond_Rst = (1<<0);
+
 		unsigned const regPwrMgmt = 0x6b;
 		unsigned const regPwrMgmt_Reset = (1<<15);
 		unsigned const regPwrMgmt_Cycle = (1<<14);
@@ -135,10 +225,22 @@ namespace embedded_drivers {
 		unsigned const regPwrMgmt_Dis_YGyro = (1<<1);
 		unsigned const regPwrMgmt_Dis_ZGyro = (1<<0);
 
+		unsigned const regFifoCount = 0x72;
+
+		unsigned const regFifoRW = 0x74;
+
 	private:
 		void * mSpiContext;
 		SpiXferCallback mSpiXfer;
 
+		uint8_t mFifoEn;
+		unsigned mFifoFrameSize;
+		uint32_t mSamplePeriodNsecs;
+		/* frames in the FIFO at the last FifoRead(), the first ones
+		 * read, and the newest taken at mFifoUsecs */
+		unsigned mFifoFrames;
+		uint32_t mFifoUsecs;
+
 		uint8_t SpiTransferHeader(bool read, uint8_t reg)
 		{ return (read?1:0) << 7 | reg; }
 
@@ -59,6 +59,38 @@ namespace embedded_drivers {
 		return (NRFX_SUCCESS == nrfx_twim_tx(twim_instance, address, buffer, len, false));
 	}
 
+	bool nrfx_twim_tx_wait_implementation(void * twim_context_with_result,
+			uint8_t address,
+			uint8_t const * buffer,
+			size_t len)
+	{
+		struct twim_context_with_result * ctx = (struct twim_context_with_result *)twim_context_with_result;
+		// set before, the event may come at once
+		ctx->success = false;
+		ctx->busy = true;
+		if(NRFX_SUCCESS != nrfx_twim_tx(ctx->twim_instance, address, buffer, len, false)) {
+			ctx->busy = false;
+			return false;
+		}
+		for(uint32_t loops = 0; ctx->busy; ++loops) {
+			if(ctx->timeout_loops && loops >= ctx->timeout_loops) {
+				// a late event then goes to the handler context
+				ctx->busy = false;
+				return false;
+			}
+		}
+		return ctx->success;
+	}
+
+	bool nrfx_twim_tx_async_implementation(void * twim_context_with_result,
+			uint8_t address,
+			uint8_t const * buffer,
+			size_t len)
+	{
+		struct twim_context_with_result * ctx = (struct twim_context_with_result *)twim_context_with_result;
+		return (NRFX_SUCCESS == nrfx_twim_tx(ctx->twim_instance, address, buffer, len, false));
+	}
+
 	bool nrfx_twim_rx_implementation(void * context,
 			uint8_t address,
 			uint8_t * buffer,
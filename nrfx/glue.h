@@ -45,6 +45,46 @@ namespace embedded_drivers {
 			uint8_t address,
 			uint8_t * buffer,
 			size_t len);
+	// With an event handler, nrfx_twim_tx_implementation() only starts the
+	// transfer. The event handler reports its outcome through this context,
+	// given to the handler and to the functions below.
+	struct twim_context_with_result {
+		nrfx_twim_t * twim_instance;
+		void * handler_context;
+		// polls of the wait before it fails the transfer, 0 waits forever
+		uint32_t timeout_loops;
+		volatile bool busy;
+		volatile bool success;
+	};
+	// Starts the transfer and waits for the event handler to report it,
+	// so it must not be called from an interrupt at or above the TWIM IRQ
+	// priority. Without timeout_loops, a lost event also hangs it.
+	bool nrfx_twim_tx_wait_implementation(void * twim_context_with_result,
+			uint8_t address,
+			uint8_t const * buffer,
+			size_t len);
+	// Only starts the transfer, the event handler reports it elsewhere.
+	bool nrfx_twim_tx_async_implementation(void * twim_context_with_result,
+			uint8_t address,
+			uint8_t const * buffer,
+			size_t len);
+	// TWIM event handler for Ssd1306I2cDisplayT::FlushAsync(), with a
+	// twim_context_with_result holding the display as context, which is also
+	// the i2cContext of the display. Use nrfx_twim_tx_wait_implementation()
+	// as i2cTx and nrfx_twim_tx_async_implementation() as i2cTxAsync.
+	template<class DISPLAY>
+	void nrfx_twim_ssd1306_event_handler(nrfx_twim_evt_t const * p_event, void * p_context)
+	{
+		twim_context_with_result * context = (twim_context_with_result*)p_context;
+		bool success = (NRFX_TWIM_EVT_DONE == p_event->type);
+		if(context->busy) {
+			context->success = success;
+			context->busy = false;
+			return;
+		}
+		DISPLAY * display = (DISPLAY*)context->handler_context;
+		display->TxComplete(success);
+	}
 
 	// SPIM glue logic
 	void nrfx_init_spim(nrfx_spim_t * spim_instance,
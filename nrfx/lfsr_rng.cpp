@@ -20,17 +20,17 @@
 #include "embedded_drivers/nrfx/lfsr_rng.h"
 
 
-embedded_drivers::LfsrFibonacci lfsr_rng;
+embedded_drivers::LfsrEntropyPool<embedded_drivers::LfsrFibonacci> lfsr_rng;
 
 static void rng_callback(uint8_t rng_data) {
-	lfsr_rng.Iterate(rng_data, 8);
+	lfsr_rng.Push(rng_data);
 }
 
 void lfsr_rng_init(void) {
 	nrfx_rng_config_t cfg;
 
 	cfg.error_correction = NRFX_RNG_CONFIG_ERROR_CORRECTION;
-	cfg.interrupt_priority = NRFX_RNG_CONFIG_ERROR_CORRECTION;
+	cfg.interrupt_priority = NRFX_RNG_CONFIG_IRQ_PRIORITY;
 
 	nrfx_rng_init(&cfg, rng_callback);
 	nrfx_rng_start();
@@ -18,8 +18,13 @@
 #pragma once
 
 #include "embedded_drivers/lfsr.h"
+#include "embedded_drivers/lfsr_entropy_pool.h"
 
-extern embedded_drivers::LfsrFibonacci lfsr_rng;
+// Pseudo-random generator that is continuously reseeded by the hardware RNG.
+// The RNG interrupt only pushes raw bytes into the pool,
+// they are folded into the LFSR in batches when bits are taken via
+// lfsr_rng.Iterate(count). Safe to use from several threads.
+extern embedded_drivers::LfsrEntropyPool<embedded_drivers::LfsrFibonacci> lfsr_rng;
 
 void lfsr_rng_deinit(void);
 
@@ -0,0 +1,75 @@
+/*
+    This file is part of embedded_drivers.
+
+    embedded_drivers is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    embedded_drivers is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with embedded_drivers.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "embedded_drivers/prbs.h"
+#include "embedded_drivers/nrfx/glue.h"
+#include "embedded_drivers/nrfx/uarte.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace embedded_drivers {
+
+	// PRBS loopback test of an SPIM instance set up via nrfx_init_spim().
+	template <class LFSR, size_t CHUNK_SIZE = 64>
+	class PrbsSpimLoopback : public PrbsSpiLoopback<LFSR, CHUNK_SIZE> {
+	public:
+		PrbsSpimLoopback(nrfx_spim_t * spim_instance)
+			: PrbsSpiLoopback<LFSR, CHUNK_SIZE>(spim_instance, nrfx_spim_xfer_implementation)
+		{
+		}
+	};
+
+	// Sends `len` bytes of PRBS via a UARTE, in chunks of CHUNK_SIZE bytes.
+	// Returns false if a transfer failed.
+	template <class LFSR, size_t CHUNK_SIZE = 64>
+	bool prbs_uarte_send(Uarte & uarte, PrbsGenerator<LFSR> & generator, size_t len)
+	{
+		uint8_t tx[CHUNK_SIZE];
+
+		while (len) {
+			size_t chunk = (len < CHUNK_SIZE) ? len : CHUNK_SIZE;
+			generator.Fill(tx, chunk);
+			if (NRFX_SUCCESS != uarte.Write((char const *)tx, chunk))
+				return false;
+			len -= chunk;
+		}
+		return true;
+	}
+
+	// Receives `len` bytes from a UARTE and checks them against a PRBS.
+	// Bytes with UARTE errors (framing, parity, overrun) are still checked,
+	// see Uarte::GetErrors() for those.
+	// Returns false if a transfer failed.
+	template <class LFSR, size_t CHUNK_SIZE = 64>
+	bool prbs_uarte_check(Uarte & uarte, PrbsChecker<LFSR> & checker, size_t len)
+	{
+		uint8_t rx[CHUNK_SIZE];
+
+		while (len) {
+			size_t chunk = (len < CHUNK_SIZE) ? len : CHUNK_SIZE;
+			if (NRFX_SUCCESS != uarte.Read((char *)rx, chunk))
+				return false;
+			checker.Check(rx, chunk);
+			len -= chunk;
+		}
+		return true;
+	}
+
+} // end of namespace embedded_drivers
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "nrfx_uarte.h"
+#include "embedded_drivers/crc.h"
 #include <cerrno>
 #include <cstddef>
 
@@ -38,6 +39,29 @@ public:
 		return nrfx_uarte_rx(&mUarteInstance, (unsigned char*)data, len);
 	}
 
+	// write data to uart, followed by its CRC-16 (CCITT-FALSE), MSB first
+	bool WriteChecked(char const * data, int const len)
+	{
+		uint16_t crc = embedded_drivers::Crc16CcittFalse::Compute((uint8_t const *)data, len);
+		uint8_t trailer[2] = { uint8_t(crc >> 8), uint8_t(crc) };
+
+		return (NRFX_SUCCESS == Write(data, len))
+			&& (NRFX_SUCCESS == Write((char const *)trailer, sizeof(trailer)));
+	}
+
+	// read data written by WriteChecked() from uart.
+	// returns false if reading failed or the CRC does not match.
+	bool ReadChecked(char * data, int const len)
+	{
+		uint8_t trailer[2];
+
+		if (NRFX_SUCCESS != Read(data, len) || NRFX_SUCCESS != Read((char *)trailer, sizeof(trailer)))
+			return false;
+
+		uint16_t crc = embedded_drivers::Crc16CcittFalse::Compute((uint8_t const *)data, len);
+		return crc == ((uint16_t(trailer[0]) << 8) | trailer[1]);
+	}
+
 	// check if at least one byte can be read
 	bool RxReady(void)
 	{
@@ -0,0 +1,283 @@
+/*
+    This file is part of embedded_drivers.
+
+    embedded_drivers is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    embedded_drivers is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with embedded_drivers.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "embedded_drivers/lfsr.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace embedded_drivers {
+
+	// Pseudo-random binary sequences for bit error rate tests of serial links,
+	// as per ITU-T O.150 (non-inverted). Each bit is the XOR of the bits sent
+	// WIDTH and TAP bits earlier, i.e. the generator polynomial is x^WIDTH + x^TAP + 1.
+	// Bits go out MSB first. INIT_VALUE is the all-ones O.150 register,
+	// see PrbsGenerator.
+	template <class T, unsigned int WIDTH, unsigned int TAP>
+	using LfsrPrbs = Lfsr<T, WIDTH, T((T(1) << WIDTH) - 1),
+		T((T(1) << (WIDTH - 1)) | (T(1) << (TAP - 1)))>;
+
+	typedef LfsrPrbs<uint8_t,   7,  6> LfsrPrbs7;
+	typedef LfsrPrbs<uint16_t, 15, 14> LfsrPrbs15;
+	typedef LfsrPrbs<uint32_t, 23, 18> LfsrPrbs23;
+	typedef LfsrPrbs<uint32_t, 31, 28> LfsrPrbs31;
+
+	static_assert(LfsrPrbs7::IsMaximal(), "PRBS7 must have maximal period.");
+	static_assert(LfsrPrbs15::IsMaximal(), "PRBS15 must have maximal period.");
+	static_assert(LfsrPrbs23::IsMaximal(), "PRBS23 must have maximal period.");
+	static_assert(LfsrPrbs31::IsMaximal(), "PRBS31 must have maximal period.");
+
+	// Returns the register state of LFSR that continues a sequence whose
+	// last LFSR::cWidth bits were `history`, oldest bit at the MSB.
+	// This is the state after shifting out `history`, so an O.150 shift
+	// register holding `history` and the Lfsr produce the same next bits.
+	template <class LFSR>
+	typename LFSR::BaseType PrbsStateAfter(typename LFSR::BaseType history)
+	{
+		typedef typename LFSR::BaseType BaseType;
+		const unsigned int width = LFSR::cWidth;
+
+		// r_k = s_k ^ sum(F_(k-1-j) * s_j, j < k) outputs s_0 .. s_(width-1)
+		BaseType state = 0;
+		for (unsigned int k = 0; k < width; ++k) {
+			BaseType bit = (history >> (width - 1 - k)) & 1;
+			for (unsigned int j = 0; j < k; ++j)
+				if ((LFSR::cFeedback >> (k - 1 - j)) & 1)
+					bit ^= (history >> (width - 1 - j)) & 1;
+			state |= BaseType(bit << k);
+		}
+
+		LFSR lfsr(state);
+		lfsr.Iterate(width);
+		return lfsr.GetRegisterState();
+	}
+
+	// Generates a PRBS 64 bits at a time.
+	template <class LFSR>
+	class PrbsGenerator {
+	public:
+		typedef typename LFSR::BaseType BaseType;
+
+		// Starts as an O.150 shift register holding `history`, by default
+		// all ones.
+		PrbsGenerator(BaseType history=LFSR::cInitValue)
+			: mLfsr(PrbsStateAfter<LFSR>(history))
+		{
+		}
+
+		// Fills `len` bytes with the next bits of the sequence, MSB first.
+		void Fill(uint8_t * buffer, size_t len)
+		{
+			for (; len >= 8; len -= 8, buffer += 8) {
+				uint64_t word = mLfsr.template IterateWide<uint64_t>();
+				for (unsigned int b = 0; b < 8; ++b)
+					buffer[b] = static_cast<uint8_t>(word >> (56 - 8 * b));
+			}
+			for (; len; --len, ++buffer)
+				*buffer = mLfsr.template IterateWide<uint8_t>();
+		}
+
+		LFSR & GetLfsr(void)
+		{
+			return mLfsr;
+		}
+
+	private:
+		LFSR mLfsr;
+	};
+
+	// Checks a received PRBS and counts bit errors, 64 bits at a time.
+	//
+	// The checker is self-synchronizing: it seeds a local generator from
+	// the first cWidth received bits and then compares against it, so every
+	// flipped bit counts as exactly one error. If more than 1/cLossRatio of
+	// the bits in a window of cWindowBits bits are wrong, it assumes to have
+	// lost synchronization (or locked onto corrupted bits) and seeds again.
+	// Synchronization is at byte granularity, bits received while not locked
+	// are not counted as checked.
+	template <class LFSR>
+	class PrbsChecker {
+	public:
+		typedef typename LFSR::BaseType BaseType;
+		static const unsigned int cWidth = LFSR::cWidth;
+		static const unsigned int cWindowBits = 1024;
+		static const unsigned int cLossRatio = 8;
+
+		PrbsChecker()
+		{
+			Reset();
+		}
+
+		void Reset(void)
+		{
+			mLocked = false;
+			mSyncBits = 0;
+			mSyncCount = 0;
+			mWindowBits = 0;
+			mWindowErrors = 0;
+			mCheckedBits = 0;
+			mBitErrors = 0;
+			mSyncLosses = 0;
+		}
+
+		// Checks `len` received bytes, MSB first.
+		// Returns the number of bit errors found in them.
+		uint64_t Check(uint8_t const * data, size_t len)
+		{
+			uint64_t errors = 0;
+
+			while (len) {
+				if (!mLocked) {
+					Synchronize(*data++);
+					--len;
+				} else if (len >= 8) {
+					uint64_t received = 0;
+					for (unsigned int b = 0; b < 8; ++b)
+						received = (received << 8) | data[b];
+					uint64_t expected = mLfsr.template IterateWide<uint64_t>();
+					errors += Account(64, __builtin_popcountll(received ^ expected));
+					data += 8;
+					len -= 8;
+				} else {
+					uint8_t expected = mLfsr.template IterateWide<uint8_t>();
+					errors += Account(8, __builtin_popcount(uint8_t(*data ^ expected)));
+					++data;
+					--len;
+				}
+			}
+
+			return errors;
+		}
+
+		bool IsLocked(void)
+		{
+			return mLocked;
+		}
+
+		// Bits compared while locked.
+		uint64_t GetCheckedBits(void)
+		{
+			return mCheckedBits;
+		}
+
+		uint64_t GetBitErrors(void)
+		{
+			return mBitErrors;
+		}
+
+		// Number of times synchronization was lost after locking.
+		uint32_t GetSyncLosses(void)
+		{
+			return mSyncLosses;
+		}
+
+	private:
+		LFSR mLfsr;
+		bool mLocked;
+		BaseType mSyncBits;
+		unsigned int mSyncCount;
+		unsigned int mWindowBits;
+		unsigned int mWindowErrors;
+		uint64_t mCheckedBits;
+		uint64_t mBitErrors;
+		uint32_t mSyncLosses;
+
+		void Synchronize(uint8_t byte)
+		{
+			mSyncBits = BaseType(mSyncBits << 8) | byte;
+			mSyncCount += 8;
+			if (mSyncCount < cWidth)
+				return;
+
+			BaseType history = mSyncBits & LFSR::cMaximalPeriod;
+			// a stuck-at-zero line would match the all-zero register
+			if (!history)
+				return;
+
+			mLfsr = LFSR(PrbsStateAfter<LFSR>(history));
+			mLocked = true;
+			mWindowBits = 0;
+			mWindowErrors = 0;
+		}
+
+		unsigned int Account(unsigned int bits, unsigned int errors)
+		{
+			mCheckedBits += bits;
+			mBitErrors += errors;
+			mWindowBits += bits;
+			mWindowErrors += errors;
+			if (mWindowBits >= cWindowBits) {
+				if (mWindowErrors * cLossRatio > mWindowBits) {
+					mLocked = false;
+					mSyncCount = 0;
+					++mSyncLosses;
+				}
+				mWindowBits = 0;
+				mWindowErrors = 0;
+			}
+			return errors;
+		}
+	};
+
+	// Sends a PRBS via SPI and checks the bytes clocked in at the same time,
+	// e.g. with MOSI looped back to MISO or with a peer echoing MOSI.
+	// Transfers are split into chunks of CHUNK_SIZE bytes on the stack,
+	// as DMA-based SPI drivers need the buffers in RAM.
+	template <class LFSR, size_t CHUNK_SIZE = 64>
+	class PrbsSpiLoopback {
+	public:
+		typedef bool(*SpiXferCallback)(void * spi_context, uint8_t const * tx_buf, size_t tx_size, uint8_t * rx_buf, size_t rx_size);
+
+		PrbsSpiLoopback(void * spiContext, SpiXferCallback spiXfer)
+			: mSpiContext(spiContext)
+			, mSpiXfer(spiXfer)
+		{
+		}
+
+		// Sends and checks `len` bytes.
+		// Returns false if a transfer failed.
+		bool Run(size_t len)
+		{
+			uint8_t tx[CHUNK_SIZE];
+			uint8_t rx[CHUNK_SIZE];
+
+			while (len) {
+				size_t chunk = (len < CHUNK_SIZE) ? len : CHUNK_SIZE;
+				mGenerator.Fill(tx, chunk);
+				if (!mSpiXfer(mSpiContext, tx, chunk, rx, chunk))
+					return false;
+				mChecker.Check(rx, chunk);
+				len -= chunk;
+			}
+			return true;
+		}
+
+		PrbsChecker<LFSR> & GetChecker(void)
+		{
+			return mChecker;
+		}
+
+	private:
+		void * mSpiContext;
+		SpiXferCallback mSpiXfer;
+		PrbsGenerator<LFSR> mGenerator;
+		PrbsChecker<LFSR> mChecker;
+	};
+
+} // end of namespace embedded_drivers
@@ -15,9 +15,8 @@
     along with embedded_drivers.  If not, see <https://www.gnu.org/licenses/>.
 */
 
-#include "machine/endian.h"
-
 #include "embedded_drivers/si7020_i2c_sensor.h"
+#include "embedded_drivers/crc.h"
 
 namespace embedded_drivers {
 
@@ -36,31 +35,45 @@ namespace embedded_drivers {
 	}
 
 	float Si7020I2cSensor::RHCodeToHumidity(uint16_t rhcode)
-	{ return 125. * __ntohs(rhcode) / 65536. - 6.; }
+	{ return 125. * rhcode / 65536. - 6.; }
 
 	float Si7020I2cSensor::TempCodeToTemperature(uint16_t tempcode)
-	{ return 175.72 * __ntohs(tempcode) / 65536. - 46.85; }
+	{ return 175.72 * tempcode / 65536. - 46.85; }
+
+	bool Si7020I2cSensor::Measure(uint8_t command, uint16_t & code)
+	{
+		// measurements return MSB, LSB and the CRC-8 of both,
+		// except for the temperature read from the last RH measurement
+		uint8_t rxbuf[3];
+		size_t len = (command == Command_ReadTempFromRHMeasurement) ? 2 : 3;
+
+		if(!mI2cTx(mI2cContext, mAddress, &command, sizeof(command)))
+			return false;
+		if(!mI2cRx(mI2cContext, mAddress, rxbuf, len))
+			return false;
+		if((len == 3) && (Crc8Si7020::Compute(rxbuf, 2) != rxbuf[2]))
+			return false;
+
+		code = (uint16_t(rxbuf[0]) << 8) | rxbuf[1];
+		return true;
+	}
 
 	float Si7020I2cSensor::ReadHumidity(void)
 	{
-		uint8_t txbuf = Command_MeasureRelativeHumidity_HoldMaster;
-		uint16_t rxbuf;
+		uint16_t code;
 
-		if(mI2cTx(mI2cContext, mAddress, &txbuf, sizeof(txbuf)))
-			if(mI2cRx(mI2cContext, mAddress, (uint8_t*)&rxbuf, sizeof(rxbuf)))
-				return RHCodeToHumidity(rxbuf);
+		if(Measure(Command_MeasureRelativeHumidity_HoldMaster, code))
+			return RHCodeToHumidity(code);
 
 		return -1.;
 	}
 
 	float Si7020I2cSensor::ReadTemperature(void)
 	{
-		uint8_t txbuf = Command_MeasureTemperature_HoldMaster;
-		uint16_t rxbuf;
+		uint16_t code;
 
-		if(mI2cTx(mI2cContext, mAddress, &txbuf, sizeof(txbuf)))
-			if(mI2cRx(mI2cContext, mAddress, (uint8_t*)&rxbuf, sizeof(rxbuf)))
-				return TempCodeToTemperature(rxbuf);
+		if(Measure(Command_MeasureTemperature_HoldMaster, code))
+			return TempCodeToTemperature(code);
 
 		return -999.;
 	}
@@ -69,19 +82,14 @@ namespace embedded_drivers {
 	{
 		float humidity = -1.;
 		float temperature = -999.;
-		uint8_t txbuf;
-		uint16_t rxbuf;
-
-		txbuf = Command_MeasureRelativeHumidity_HoldMaster;
+		uint16_t code;
 
-		if(mI2cTx(mI2cContext, mAddress, &txbuf, sizeof(txbuf)))
-			if(mI2cRx(mI2cContext, mAddress, (uint8_t*)&rxbuf, sizeof(rxbuf)))
-				humidity = RHCodeToHumidity(rxbuf);
+		if(Measure(Command_MeasureRelativeHumidity_HoldMaster, code)) {
+			humidity = RHCodeToHumidity(code);
 
-		txbuf = Command_ReadTempFromRHMeasurement;
-		if(mI2cTx(mI2cContext, mAddress, &txbuf, sizeof(txbuf)))
-			if(mI2cRx(mI2cContext, mAddress, (uint8_t*)&rxbuf, sizeof(rxbuf)))
-				temperature = TempCodeToTemperature(rxbuf);
+			if(Measure(Command_ReadTempFromRHMeasurement, code))
+				temperature = TempCodeToTemperature(code);
+		}
 
 		return std::pair<float,float>(humidity, temperature);
 	}
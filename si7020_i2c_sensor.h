@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <utility>
 
@@ -31,6 +32,8 @@ namespace embedded_drivers {
 				bool(*i2cRx)(void * context, uint8_t address, uint8_t * buffer, size_t len));
 		~Si7020I2cSensor(void);
 
+		// Measurements are validated with the CRC-8 sent by the sensor.
+		// Return -1 (humidity) or -999 (temperature) on errors.
 		float ReadHumidity(void);
 		float ReadTemperature(void);
 		std::pair<float, float> ReadHumidityTemperature(void);
@@ -38,6 +41,7 @@ namespace embedded_drivers {
 	private:
 		float TempCodeToTemperature(uint16_t tempcode);
 		float RHCodeToHumidity(uint16_t rhcode);
+		bool Measure(uint8_t command, uint16_t & code);
 
 		const uint8_t Command_MeasureRelativeHumidity_HoldMaster = 0xe5;
 		const uint8_t Command_MeasureRelativeHumidity_NoHoldMaster = 0xf5;
@@ -0,0 +1,169 @@
+/*
+    This file is part of embedded_drivers.
+
+    embedded_drivers is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    embedded_drivers is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with embedded_drivers.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace embedded_drivers {
+
+	// Player of compressed animations and images for Ssd1306I2cDisplayT.
+	//
+	// Each frame of the stream only holds the spans of display pages that
+	// differ from the frame before, in the page layout of the display,
+	// run-length coded. The first frame is relative to a cleared screen.
+	// Spans are decoded straight into the transfer buffer of the display,
+	// so neither the stream nor a frame needs to be in RAM.
+	// Streams are made on the host by tools/ssd1306_animation_encode.
+	//
+	// Format, multi-byte numbers little endian:
+	//   header: 'S' 'A' version(1) width pages period_ms(2) frames(2)
+	//   frame:  span* 0x00
+	//   span:   page+1 column length-1 run*, the runs giving `length` bytes
+	//   run:    n < 0x80: n+1 literal bytes follow
+	//           n >= 0x80: the next byte, repeated n-0x80+2 times
+	class Ssd1306Animation {
+	public:
+		static const uint8_t cVersion = 1;
+		static const size_t cHeaderSize = 9;
+
+		Ssd1306Animation(uint8_t const * stream, size_t len)
+			: mStream(stream)
+			, mEnd(stream + len)
+			, mValid(len >= cHeaderSize && stream[0] == 'S' && stream[1] == 'A'
+					&& stream[2] == cVersion && stream[3] && stream[3] <= 128
+					&& stream[4] && stream[4] <= 8)
+		{
+			Rewind();
+		}
+
+		bool IsValid(void)		{ return mValid; }
+		unsigned Width(void)		{ return mStream[3]; }
+		unsigned Pages(void)		{ return mStream[4]; }
+		unsigned FramePeriodMsecs(void)	{ return mStream[5] | (mStream[6] << 8); }
+		unsigned FrameCount(void)	{ return mStream[7] | (mStream[8] << 8); }
+		// Frame that DrawFrame() draws next.
+		unsigned Frame(void)		{ return mFrame; }
+
+		// Starts over at the first frame, which expects a cleared screen.
+		void Rewind(void)
+		{
+			mPos = mStream + cHeaderSize;
+			mFrame = 0;
+			mRun = 0;
+			mBroken = false;
+		}
+
+		// Draws the changes of the next frame to the top left of `display`.
+		// With a shadow framebuffer, they are sent by the next Flush().
+		// Returns false after the last frame, or if the stream is broken;
+		// the display may then show part of a frame.
+		template <class DISPLAY>
+		bool DrawFrame(DISPLAY & display)
+		{
+			if(!mValid || mFrame >= FrameCount())
+				return false;
+			if(Width() > DISPLAY::cDisplayWidth || 8 * Pages() > DISPLAY::cDisplayHeight)
+				return false;
+
+			bool ret = true;
+			while(true) {
+				if(mPos >= mEnd)
+					return Broken();
+				unsigned page = *mPos++;
+				if(!page)
+					break;
+				if(mEnd - mPos < 2)
+					return Broken();
+				unsigned col = *mPos++;
+				unsigned len = *mPos++ + 1;
+				if(page > Pages() || col + len > Width())
+					return Broken();
+
+				mRun = 0;
+				mBroken = false;
+				ret = display.DrawSpan(page - 1, col, len, Fill, this) && ret;
+				if(mBroken || mRun)
+					return Broken();
+			}
+			++mFrame;
+			return ret;
+		}
+
+	private:
+		uint8_t const * const mStream;
+		uint8_t const * const mEnd;
+		bool const mValid;
+
+		uint8_t const * mPos;
+		unsigned mFrame;
+
+		// what is left of the current run
+		unsigned mRun;
+		bool mLiteral;
+		uint8_t mValue;
+		bool mBroken;
+
+		bool Broken(void)
+		{
+			mFrame = FrameCount();
+			return false;
+		}
+
+		static void Fill(void * context, uint8_t * buffer, unsigned len)
+		{
+			Ssd1306Animation & self = *static_cast<Ssd1306Animation *>(context);
+
+			while(len) {
+				if(!self.mRun) {
+					if(self.mEnd - self.mPos < 2)
+						break;
+					uint8_t n = *self.mPos++;
+					self.mLiteral = (n < 0x80);
+					self.mRun = self.mLiteral ? (n + 1) : (n - 0x80 + 2);
+					if(!self.mLiteral)
+						self.mValue = *self.mPos++;
+				}
+
+				unsigned count = (self.mRun < len) ? self.mRun : len;
+				if(self.mLiteral) {
+					if(size_t(self.mEnd - self.mPos) < count)
+						break;
+					for(unsigned i = 0; i < count; ++i)
+						buffer[i] = self.mPos[i];
+					self.mPos += count;
+				} else {
+					for(unsigned i = 0; i < count; ++i)
+						buffer[i] = self.mValue;
+				}
+				buffer += count;
+				len -= count;
+				self.mRun -= count;
+			}
+
+			// the stream ended early, the frame is given up
+			if(len) {
+				self.mBroken = true;
+				self.mRun = 0;
+				for(unsigned i = 0; i < len; ++i)
+					buffer[i] = 0;
+			}
+		}
+	};
+
+} // end of namespace embedded_drivers
@@ -0,0 +1,170 @@
+/*
+    This file is part of embedded_drivers.
+
+    embedded_drivers is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    embedded_drivers is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with embedded_drivers.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+namespace embedded_drivers {
+
+	// Shares one I2C bus between several Ssd1306I2cDisplayT, e.g. at 0x3c
+	// and 0x3d.
+	//
+	// The displays need shadow framebuffers. Instead of each flushing all
+	// its changes at once, and a full screen on one display holding back a
+	// status line on the other for ~25ms at 400kHz, Step() sends a slice of
+	// about `sliceBytes` of dirty page rows for one display at a time, round
+	// robin over the displays with changes.
+	// For each display, the latency from the first Step() that finds changes
+	// until they are all sent is measured with the `usecs` clock.
+	template <unsigned MAX_DISPLAYS = 2>
+	class Ssd1306Compositor {
+	public:
+		struct Statistics {
+			uint32_t mUpdates;	// times all changes were sent
+			uint32_t mLastUsecs;	// latency of the last one
+			uint32_t mMaxUsecs;
+			uint64_t mTotalUsecs;
+			uint32_t mSlices;
+		};
+
+		Ssd1306Compositor(uint32_t(*usecs)(void * context), void * usecsContext,
+				unsigned sliceBytes = 128)
+			: mUsecs(usecs)
+			, mUsecsContext(usecsContext)
+			, mSliceBytes(sliceBytes)
+			, mCount(0)
+			, mNext(0)
+		{
+		}
+
+		// Returns the index of the display for Stats(), or -1 if full.
+		template <class DISPLAY>
+		int Add(DISPLAY & display)
+		{
+			if(mCount >= MAX_DISPLAYS)
+				return -1;
+			Entry & entry = mEntries[mCount];
+			entry.mDisplay = &display;
+			entry.mHasChanges = HasChanges<DISPLAY>;
+			entry.mFlushPart = FlushPart<DISPLAY>;
+			entry.mPending = false;
+			ResetStatistics(mCount);
+			return mCount++;
+		}
+
+		// Sends one slice for the next display with changes. Returns false
+		// if there was nothing to send, or on bus errors.
+		bool Step(void)
+		{
+			for(unsigned i = 0; i < mCount; ++i) {
+				Entry & entry = mEntries[mNext];
+				mNext = (mNext + 1) % mCount;
+				if(!entry.mHasChanges(entry.mDisplay)) {
+					entry.mPending = false;
+					continue;
+				}
+
+				if(!entry.mPending) {
+					entry.mPending = true;
+					entry.mSince = mUsecs(mUsecsContext);
+				}
+				bool ret = entry.mFlushPart(entry.mDisplay, mSliceBytes);
+				++entry.mStatistics.mSlices;
+				if(!entry.mHasChanges(entry.mDisplay)) {
+					Statistics & stats = entry.mStatistics;
+					uint32_t latency = mUsecs(mUsecsContext) - entry.mSince;
+					entry.mPending = false;
+					++stats.mUpdates;
+					stats.mLastUsecs = latency;
+					if(latency > stats.mMaxUsecs)
+						stats.mMaxUsecs = latency;
+					stats.mTotalUsecs += latency;
+				}
+				return ret;
+			}
+			return false;
+		}
+
+		// Steps until no display has changes left.
+		bool Flush(void)
+		{
+			bool ret = true;
+			while(HasChanges())
+				ret = Step() && ret;
+			return ret;
+		}
+
+		bool HasChanges(void)
+		{
+			for(unsigned i = 0; i < mCount; ++i)
+				if(mEntries[i].mHasChanges(mEntries[i].mDisplay))
+					return true;
+			return false;
+		}
+
+		Statistics const & Stats(unsigned index)	{ return mEntries[index].mStatistics; }
+
+		// Average latency, in microseconds.
+		uint32_t AverageUsecs(unsigned index)
+		{
+			Statistics const & stats = mEntries[index].mStatistics;
+			return stats.mUpdates ? uint32_t(stats.mTotalUsecs / stats.mUpdates) : 0;
+		}
+
+		void ResetStatistics(unsigned index)
+		{
+			Statistics & stats = mEntries[index].mStatistics;
+			stats.mUpdates = 0;
+			stats.mLastUsecs = 0;
+			stats.mMaxUsecs = 0;
+			stats.mTotalUsecs = 0;
+			stats.mSlices = 0;
+		}
+
+	private:
+		struct Entry {
+			void * mDisplay;
+			bool(*mHasChanges)(void * display);
+			bool(*mFlushPart)(void * display, unsigned bytes);
+			bool mPending;
+			uint32_t mSince;
+			Statistics mStatistics;
+		};
+
+		uint32_t(* const mUsecs)(void * context);
+		void * const mUsecsContext;
+		unsigned const mSliceBytes;
+
+		Entry mEntries[MAX_DISPLAYS];
+		unsigned mCount;
+		unsigned mNext;
+
+		template <class DISPLAY>
+		static bool HasChanges(void * display)
+		{
+			return static_cast<DISPLAY *>(display)->HasChanges();
+		}
+
+		template <class DISPLAY>
+		static bool FlushPart(void * display, unsigned bytes)
+		{
+			return static_cast<DISPLAY *>(display)->FlushPart(bytes);
+		}
+	};
+
+} // end of namespace embedded_drivers
@@ -0,0 +1,165 @@
+/*
+    This file is part of embedded_drivers.
+
+    embedded_drivers is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    embedded_drivers is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with embedded_drivers.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+namespace embedded_drivers {
+
+	// Paces the updates of an Ssd1306I2cDisplayT into frames.
+	//
+	// The display needs a shadow framebuffer, so Puts() and friends from
+	// anywhere in the firmware only draw into it, and drawing the same text
+	// into a cell again changes nothing. Poll() then flushes whatever changed,
+	// at most `maxFps` times a second, and only while the bus time spent on
+	// the display stays within `budgetPercent` of the time passed.
+	// A frame that is due while changes wait, but the bus budget is spent or
+	// an asynchronous flush still runs, is counted as dropped; its changes go
+	// out with the next frame. So do those of a frame whose flush failed.
+	template <class DISPLAY>
+	class Ssd1306FrameScheduler {
+	public:
+		// With `async`, frames are sent with FlushAsync(), which needs
+		// DISPLAY::SetAsyncTx().
+		Ssd1306FrameScheduler(DISPLAY & display, unsigned maxFps,
+				unsigned busHz = 400000, unsigned budgetPercent = 100, bool async = false)
+			: mDisplay(display)
+			, mFramePeriod(FramePeriod(maxFps))
+			, mBusHz(busHz)
+			, mBudgetPercent(budgetPercent)
+			, mAsync(async)
+			, mLastPoll(0)
+			, mLastFrame(0)
+			, mCredit(0)
+			, mStarted(false)
+		{
+			ResetStatistics(0);
+		}
+
+		// Call this often with a free running microsecond clock, which may
+		// wrap. Returns true if a frame was sent.
+		bool Poll(uint32_t nowUsecs)
+		{
+			if(!mStarted) {
+				mStarted = true;
+				mLastPoll = nowUsecs;
+				mLastFrame = nowUsecs - mFramePeriod;
+				mStatisticsStart = nowUsecs;
+			}
+
+			// the budget refills while time passes, up to one frame's share
+			int64_t const limit = int64_t(mFramePeriod) * mBudgetPercent / 100;
+			mCredit += int64_t(nowUsecs - mLastPoll) * mBudgetPercent / 100;
+			if(mCredit > limit)
+				mCredit = limit;
+			mLastPoll = nowUsecs;
+
+			if(nowUsecs - mLastFrame < mFramePeriod)
+				return false;
+			if(!mDisplay.HasChanges())
+				return false;
+
+			if(mCredit < 0 || mDisplay.IsFlushing()) {
+				++mFramesDropped;
+				mLastFrame = nowUsecs;
+				return false;
+			}
+			mLastFrame = nowUsecs;
+			return Send();
+		}
+
+		// Sends pending changes right away, e.g. before going to sleep.
+		// The bus time still counts against the budget.
+		bool FlushNow(void)
+		{
+			return Send();
+		}
+
+		// Frames sent and dropped, and the bus time spent on them, since
+		// ResetStatistics().
+		uint32_t Frames(void)		{ return mFrames; }
+		uint32_t FramesDropped(void)	{ return mFramesDropped; }
+		uint32_t BusUsecs(void)		{ return mBusUsecs; }
+
+		// Share of the time until `nowUsecs` the bus was busy with the
+		// display, in per mille.
+		unsigned BusUtilization(uint32_t nowUsecs)
+		{
+			uint32_t elapsed = nowUsecs - mStatisticsStart;
+			if(!elapsed)
+				return 0;
+			return unsigned(uint64_t(mBusUsecs) * 1000 / elapsed);
+		}
+
+		void ResetStatistics(uint32_t nowUsecs)
+		{
+			mStatisticsStart = nowUsecs;
+			mFrames = 0;
+			mFramesDropped = 0;
+			mBusUsecs = 0;
+		}
+
+	private:
+		DISPLAY & mDisplay;
+		uint32_t const mFramePeriod;
+		unsigned const mBusHz;
+		unsigned const mBudgetPercent;
+		bool const mAsync;
+
+		uint32_t mLastPoll;
+		uint32_t mLastFrame;
+		// Bus time left of the budget, in microseconds. A frame may spend
+		// more than is left, the following frames wait until it is paid off.
+		int64_t mCredit;
+		bool mStarted;
+
+		uint32_t mStatisticsStart;
+		uint32_t mFrames;
+		uint32_t mFramesDropped;
+		uint32_t mBusUsecs;
+
+		static uint32_t FramePeriod(unsigned maxFps)
+		{
+			assert(maxFps > 0);
+			return 1000000 / maxFps;
+		}
+
+		bool Send(void)
+		{
+			uint32_t bytes = mDisplay.TxBytes();
+			uint32_t transfers = mDisplay.TxTransfers();
+			bool ret = mAsync ? mDisplay.FlushAsync() : mDisplay.Flush();
+			bytes = mDisplay.TxBytes() - bytes;
+			transfers = mDisplay.TxTransfers() - transfers;
+			// a failed frame is dropped, the display resends its changes
+			if(!ret)
+				++mFramesDropped;
+			else if(bytes)
+				++mFrames;
+
+			// start, address byte and stop of each transfer, 9 bits per byte
+			uint64_t bits = 9 * uint64_t(bytes + transfers) + 2 * transfers;
+			uint32_t usecs = uint32_t(bits * 1000000 / mBusHz);
+			mBusUsecs += usecs;
+			mCredit -= usecs;
+			return ret;
+		}
+	};
+
+} // end of namespace embedded_drivers
@@ -0,0 +1,180 @@
+/*
+    This file is part of embedded_drivers.
+
+    embedded_drivers is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    embedded_drivers is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with embedded_drivers.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "embedded_drivers/lfsr.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace embedded_drivers {
+
+	// 4-level grayscale on an Ssd1306I2cDisplayT, by temporal dithering.
+	//
+	// Pixels hold a level of 0..3, kept as two bitplanes in the page layout
+	// of the display. Each Refresh() draws one sub-frame into the shadow
+	// framebuffer of the display, which it needs: level 3 pixels are on,
+	// level 2 pixels on with a chance of 1/2, level 1 pixels with a chance
+	// of 1/4, as decided by the bits of an LFSR. Refresh at a high rate,
+	// e.g. with Ssd1306FrameScheduler, and the eye sees the average.
+	// The shadow only marks the bytes whose dithered pixels changed, so the
+	// flush sends just those; areas of level 0 and 3 cost nothing after the
+	// first sub-frame and no LFSR bits either.
+	// Sub-frames are computed 32 pixels at a time from 32 bit words of the
+	// bitplanes and of LFSR output.
+	template <class DISPLAY, class LFSR = LfsrDefault32>
+	class Ssd1306GraySurface {
+	public:
+		static const unsigned cLevels = 4;
+		static const unsigned cWidth = DISPLAY::cDisplayWidth;
+		static const unsigned cHeight = DISPLAY::cDisplayHeight;
+		static const unsigned cPages = cHeight / 8;
+
+		Ssd1306GraySurface(DISPLAY & display, LFSR lfsr = LFSR())
+			: mDisplay(display)
+			, mLfsr(lfsr)
+			, mFill(0)
+		{
+			Clear();
+		}
+
+		void Clear(unsigned level = 0)
+		{
+			memset(mPlane[0], (level & 1) ? 0xff : 0, sizeof(mPlane[0]));
+			memset(mPlane[1], (level & 2) ? 0xff : 0, sizeof(mPlane[1]));
+		}
+
+		unsigned GetPixel(int x, int y)
+		{
+			if(x < 0 || x >= int(cWidth) || y < 0 || y >= int(cHeight))
+				return 0;
+			unsigned i = (y / 8) * cWidth + x;
+			unsigned bit = y % 8;
+			return ((mPlane[0][i] >> bit) & 1) | (((mPlane[1][i] >> bit) & 1) << 1);
+		}
+
+		// Drawing is clipped to the panel, levels above 3 are taken as 3.
+		void SetPixel(int x, int y, unsigned level)
+		{
+			FillRect(x, y, 1, 1, level);
+		}
+
+		void FillRect(int x, int y, int w, int h, unsigned level)
+		{
+			level = std::min(level, cLevels - 1);
+			int x0 = std::max(x, 0);
+			int x1 = std::min(x + w, int(cWidth));
+			int y0 = std::max(y, 0);
+			int y1 = std::min(y + h, int(cHeight));
+			if(x0 >= x1 || y0 >= y1)
+				return;
+
+			for(int row = y0 & ~7; row < y1; row += 8) {
+				unsigned top = std::max(y0 - row, 0);
+				unsigned bottom = std::min(y1 - row, 8);
+				uint8_t mask = (0xff << top) & (0xff >> (8 - bottom));
+				for(unsigned plane = 0; plane < 2; ++plane) {
+					uint8_t * p = &mPlane[plane][(row / 8) * cWidth];
+					bool set = (level >> plane) & 1;
+					for(int col = x0; col < x1; ++col)
+						p[col] = set ? (p[col] | mask) : (p[col] & ~mask);
+				}
+			}
+		}
+
+		// Bresenham, e.g. for the segments of a trend plot.
+		void DrawLine(int x0, int y0, int x1, int y1, unsigned level)
+		{
+			int dx = std::abs(x1 - x0);
+			int dy = -std::abs(y1 - y0);
+			int sx = (x0 < x1) ? 1 : -1;
+			int sy = (y0 < y1) ? 1 : -1;
+			int err = dx + dy;
+			for(;;) {
+				SetPixel(x0, y0, level);
+				if(x0 == x1 && y0 == y1)
+					break;
+				int e2 = 2 * err;
+				if(e2 >= dy) {
+					err += dy;
+					x0 += sx;
+				}
+				if(e2 <= dx) {
+					err += dx;
+					y0 += sy;
+				}
+			}
+		}
+
+		// Draws the next sub-frame into the shadow of the display,
+		// to be sent by its next Flush().
+		bool Refresh(void)
+		{
+			bool ret = true;
+			mFill = 0;
+			for(unsigned page = 0; page < cPages; ++page)
+				ret = mDisplay.DrawSpan(page, 0, cWidth, Fill, this) && ret;
+			return ret;
+		}
+
+	private:
+		DISPLAY & mDisplay;
+		LFSR mLfsr;
+		// bit 0 and bit 1 of the level of each pixel
+		uint8_t mPlane[2][cWidth * cPages];
+		// next byte of the sub-frame to compute
+		unsigned mFill;
+
+		// on = level 3, or level 2 and r1 clear, or level 1 and r0, r1 clear
+		static uint32_t Dither(uint32_t p0, uint32_t p1, uint32_t r0, uint32_t r1)
+		{
+			return (p0 & p1) | (p1 & ~p0 & ~r1) | (p0 & ~p1 & ~r0 & ~r1);
+		}
+
+		static void Fill(void * context, uint8_t * buffer, unsigned len)
+		{
+			Ssd1306GraySurface & self = *static_cast<Ssd1306GraySurface *>(context);
+			uint8_t const * p0 = &self.mPlane[0][self.mFill];
+			uint8_t const * p1 = &self.mPlane[1][self.mFill];
+			self.mFill += len;
+
+			unsigned i = 0;
+			for(; i + 4 <= len; i += 4) {
+				uint32_t low, high;
+				memcpy(&low, &p0[i], 4);
+				memcpy(&high, &p1[i], 4);
+				uint32_t on = low & high;
+				if(low ^ high) {
+					uint32_t r0 = self.mLfsr.template IterateWide<uint32_t>();
+					uint32_t r1 = self.mLfsr.template IterateWide<uint32_t>();
+					on = Dither(low, high, r0, r1);
+				}
+				memcpy(&buffer[i], &on, 4);
+			}
+			for(; i < len; ++i) {
+				uint8_t on = p0[i] & p1[i];
+				if(p0[i] ^ p1[i])
+					on = Dither(p0[i], p1[i], self.mLfsr.Iterate(8), self.mLfsr.Iterate(8));
+				buffer[i] = on;
+			}
+		}
+	};
+
+} // end of namespace embedded_drivers
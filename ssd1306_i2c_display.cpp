@@ -19,88 +19,247 @@
 #include <cstring>
 #include <cerrno>
 #include <cassert>
+#include <cstdlib>
 
 #include "embedded_drivers/ssd1306_i2c_display.h"
 
 namespace embedded_drivers {
 
-	Ssd1306I2cDisplay::Ssd1306I2cDisplay(void * sleepMsecsContext,
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	uint8_t const Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::cClearBlock[1 + 64] = { 0x40 };
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::Ssd1306I2cDisplayT(void * sleepMsecsContext,
 				void(*sleepMsecs)(void * context, unsigned msecs),
 				void * i2cContext,
 				bool(*i2cTx)(void * context, uint8_t address, uint8_t const * buffer, size_t len),
 				bool(*i2cRx)(void * context, uint8_t address, uint8_t * buffer, size_t len),
 				const uint8_t * font_data,
-				unsigned font_width,
-				unsigned font_height,
-				bool flipLongEdge)
-		: mDisplayWidth(128)
-		, mDisplayHeight(64)
-		, mFontData(font_data)
-		, mFontWidth(font_width)
-		, mFontHeight(font_height)
-		, mFontFaceSize((mFontWidth * mFontHeight) / 8)
-		, mColumnCount(mDisplayWidth/mFontWidth)
-		, mLineCount(mDisplayHeight/mFontHeight)
+				bool flipLongEdge,
+				uint8_t * shadowFramebuffer,
+				uint8_t address)
+		: mFontData(font_data)
 		, mFlipLongEdge(flipLongEdge)
-		, mAddress(0x3c)
-		, mClearCommand{ 0x40,    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-					  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-					  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-					  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-					  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-					  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-					  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-					  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, }
+		, mAddress(address)
+		, mFramebuffer(shadowFramebuffer)
+		, mViewPortDirty(false)
+		, mFrontBuffer(NULL)
+		, mAsyncCount(0)
+		, mAsyncNext(0)
+		, mAsyncBusy(false)
+		, mAsyncFailed(false)
+		, mI2cTxAsync(NULL)
+		, mAsyncCompletion(NULL)
+		, mAsyncCompletionContext(NULL)
+		, mScrollback(NULL)
+		, mScrollbackLines(0)
+		, mTermModulo(1)
+		, mTermTop(0)
+		, mTermBack(0)
+		, mTermHistory(0)
+		, mRenderDeferred(0)
+		, mCommands{ 0x00 }
+		, mCommandCount(0)
+		, mWindowQueued(false)
 		, mSleepMsecsContext(sleepMsecsContext)
 		, mSleepMsecs(sleepMsecs)
 		, mI2cContext(i2cContext)
+		, mTxBytes(0)
+		, mTxTransfers(0)
 		, mI2cTx(i2cTx)
 		, mI2cRx(i2cRx)
 	{
-		assert(8 == mFontHeight);
+		for(unsigned page = 0; page < cMaxPages; ++page)
+			MarkClean(page);
 		Init();
 	}
 
-	Ssd1306I2cDisplay::~Ssd1306I2cDisplay(void)
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::~Ssd1306I2cDisplayT(void)
 	{
 	}
 
-	void Ssd1306I2cDisplay::Clear(void)
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::Clear(void)
 	{
+		if(mScrollback) {
+			// the screen moves into the scrollback
+			for(unsigned line = 0; line < cLineCount; ++line)
+				TermScroll();
+			mTermBack = 0;
+			CursorSetPosition(0, 0);
+			return;
+		}
 
-		SSD1306DisplayCommand(0x22, 0, uint8_t(mLineCount-1));
-		SSD1306DisplayCommand(0x21, 0, uint8_t(mDisplayWidth-1));
-		for(unsigned i = 0; i < mLineCount*mDisplayWidth / (mClearCommand.size()-1); ++i)
-			I2cTx(mClearCommand);
-
+		ClearArea(0, cVisiblePages, 0, cDisplayWidth);
 		SetViewPortY(0);
 		CursorSetPosition(0, 0);
+		FlushCommands();
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::ClearArea(unsigned page, unsigned pages, unsigned col, unsigned width)
+	{
+		if(!width)
+			return;
+
+		for(unsigned row = 0; row < pages; ) {
+			unsigned first = (page + row) % cMaxPages;
+			unsigned count = std::min(pages - row, cMaxPages - first);
+			row += count;
+
+			if(mFramebuffer) {
+				for(unsigned i = 0; i < count; ++i)
+					ShadowFill(first + i, col, 0, width);
+				continue;
+			}
+
+			Window(first, first + count - 1, col, col + width - 1);
+			for(unsigned todo = count * width; todo; ) {
+				unsigned len = std::min<unsigned>(todo, sizeof(cClearBlock)-1);
+				I2cTxData(cClearBlock, 1 + len);
+				todo -= len;
+			}
+		}
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	int Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::WriteRun(char const * data, int len)
+	{
+		unsigned const col = mCursorX;
+		unsigned const page = LinePage(mCursorY);
+
+		unsigned width = 0;
+		while(int(width) < len && col + width < cColumnCount && IsPrintable(data[width]))
+			++width;
+		if(width < 2 || page + cPagesPerLine > cMaxPages)
+			return 0;
+
+		// Collect further lines while the rectangle stays in view and
+		// in the RAM, without scrolling.
+		unsigned lines = 1;
+		int used = width;
+		while(mCursorY + lines < cLineCount && page + (lines+1)*cPagesPerLine <= cMaxPages) {
+			// both continue in column 0
+			int skip;
+			if(col + width == cColumnCount)
+				skip = 0;
+			else if(used + 1 < len && data[used] == '\r' && data[used+1] == '\n')
+				skip = 2;
+			else
+				break;
+			if(col != 0 || used + skip + int(width) > len)
+				break;
+
+			// only text that ends there, a longer one would be cut in two
+			unsigned i;
+			for(i = 0; i < width; ++i)
+				if(!IsPrintable(data[used + skip + i]))
+					break;
+			if(i < width)
+				break;
+			if(col + width < cColumnCount && used + skip + int(width) < len
+					&& IsPrintable(data[used + skip + width]))
+				break;
+			used += skip + width;
+			++lines;
+		}
+
+		// one window, the data split only where the staging buffer is full
+		Window(page, page + lines*cPagesPerLine - 1, col*cFontWidth, (col+width)*cFontWidth - 1);
+		bool ret = true;
+		unsigned staged = 0;
+		char const * text = data;
+		for(unsigned line = 0; line < lines; ++line) {
+			for(unsigned row = 0; row < cPagesPerLine; ++row) {
+				for(unsigned i = 0; i < width; ++i) {
+					uint8_t const * slice = Glyph(text[i]) + row*cFontWidth;
+					for(unsigned j = 0; j < cFontWidth; ++j) {
+						TxData()[staged++] = slice[j];
+						if(staged == cTxCapacity) {
+							ret = TxStaged(staged) && ret;
+							staged = 0;
+						}
+					}
+				}
+			}
+			// the next line starts after its separator, if any
+			text += width;
+			if(line + 1 < lines && col + width != cColumnCount)
+				text += 2;
+		}
+		if(staged)
+			ret = TxStaged(staged) && ret;
+
+		// the address pointer is back at the start of the window
+		mCursorY += lines - 1;
+		mCursorX = col + width;
+		CursorApplyPosition();
+		return ret ? used : -EINVAL;
 	}
 
-	void Ssd1306I2cDisplay::ClearColumnsAfterCursor(bool fixCursorPosition)
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	bool Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::DrawText(unsigned page, unsigned col, uint8_t const * text, unsigned len, bool cursorWindow)
 	{
-		for(unsigned i = 0; i < mColumnCount-mCursorX; ++i)
-			DrawFont(0);
+		assert(len * cFontWidth <= cTxCapacity);
+
+		bool ret = true;
+		for(unsigned row = 0; row < cPagesPerLine; ++row) {
+			unsigned current = (page + row) % cMaxPages;
+
+			uint8_t * p = TxData();
+			for(unsigned i = 0; i < len; ++i, p += cFontWidth)
+				memcpy(p, Glyph(text[i]) + row*cFontWidth, cFontWidth);
+
+			if(mFramebuffer) {
+				ShadowWrite(current, col, TxData(), len * cFontWidth);
+				continue;
+			}
+
+			// a new window for the first row, and where the line wraps around the RAM
+			if(!(cursorWindow && cPagesPerLine == 1) && (row == 0 || current == 0)) {
+				unsigned last = std::min(current + cPagesPerLine - row, cMaxPages) - 1;
+				Window(current, last, col, col + len*cFontWidth - 1);
+			}
+			ret = TxStaged(len * cFontWidth) && ret;
+		}
+		return ret;
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::ClearColumnsAfterCursor(bool fixCursorPosition)
+	{
+		if(mScrollback)
+			TermFill(TermLine(mCursorY), mCursorX, ' ', cColumnCount-mCursorX);
+		else
+			ClearArea(LinePage(mCursorY), cPagesPerLine, mCursorX*cFontWidth, (cColumnCount-mCursorX)*cFontWidth);
 		if(fixCursorPosition)
 			CursorSetPosition(mCursorX, mCursorY);
+		Present();
 	}
 
-	void Ssd1306I2cDisplay::ClearLinesAfterCursor(bool fixCursorPosition)
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::ClearLinesAfterCursor(bool fixCursorPosition)
 	{
-		int lines = mLineCount-mCursorY-1;
+		int lines = cLineCount-mCursorY-1;
 		if(lines > 0) {
-			SSD1306DisplayCommand(0x22, uint8_t(mCursorY+1), uint8_t(mLineCount-1));
-			SSD1306DisplayCommand(0x21, 0, uint8_t(mDisplayWidth-1));
-
-			for(unsigned i = 0; i < lines * mDisplayWidth / (mClearCommand.size()-1); ++i)
-				I2cTx(mClearCommand);
+			// lines are rotated by the view port, so clear page by page
+			for(unsigned line = mCursorY+1; line < cLineCount; ++line) {
+				if(mScrollback) {
+					TermFill(TermLine(line), 0, ' ', cColumnCount);
+					continue;
+				}
+				ClearArea(LinePage(line), cPagesPerLine, 0, cDisplayWidth);
+			}
 
 			if(fixCursorPosition)
 				CursorSetPosition(mCursorX, mCursorY);
+			Present();
 		}
 	}
 
-	void Ssd1306I2cDisplay::ClearAfterCursor(bool resetCursorToNull)
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::ClearAfterCursor(bool resetCursorToNull)
 	{
 		ClearColumnsAfterCursor(false);
 		ClearLinesAfterCursor(!resetCursorToNull);
@@ -108,7 +267,8 @@ namespace embedded_drivers {
 			CursorSetPosition(0, 0);
 	}
 
-	bool Ssd1306I2cDisplay::PutChar(char const c)
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	bool Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::PutChar(char const c)
 	{
 		unsigned l = c;
 
@@ -132,6 +292,7 @@ namespace embedded_drivers {
 			case '\x01': // move cursor to the right
 				mCursorX += 1;
 				CursorApplyPosition();
+				Present();
 				return true;
 			case '\x02':
 				ClearColumnsAfterCursor();
@@ -153,26 +314,43 @@ namespace embedded_drivers {
 
 			bool ret = DrawFont(l);
 			mCursorX += 1;
-			if(mCursorX >= mColumnCount)
+			if(mCursorX >= cColumnCount)
 				CursorApplyPosition();
+			Present();
 
 			return ret;
 		}
 	}
 
-	bool Ssd1306I2cDisplay::Puts(char const *str)
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	bool Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::Puts(char const *str)
 	{
 		int len = strlen(str);
 		return len == Write(str, len);
 	}
 
-	int Ssd1306I2cDisplay::Write(char const *data, int const len)
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	int Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::Write(char const *data, int const len)
 	{
+		int ret = len;
 		int todo = len;
+		++mRenderDeferred;
 		while(todo) {
+			if(!mFramebuffer && !mScrollback) {
+				int used = WriteRun(data, todo);
+				if(used < 0) {
+					ret = used;
+					break;
+				} else if(used) {
+					data += used;
+					todo -= used;
+					continue;
+				}
+			}
+
 			// check when a control character or a newline-situation would be met
 			// and try to transfer everything until then in a single transfer.
-			ssize_t maxChunk = mColumnCount - mCursorX - 1;
+			ssize_t maxChunk = cColumnCount - mCursorX - 1;
 			ssize_t maxPrintable;
 			if(maxChunk > 0) {
 				for(maxPrintable = 0; maxPrintable < todo; ++maxPrintable)
@@ -180,8 +358,10 @@ namespace embedded_drivers {
 						break;
 				maxChunk = std::min(maxChunk, maxPrintable);
 				if(maxChunk >= 2) {
-					if(!DrawFontMulti((const uint8_t*)data, maxChunk))
-						return -EINVAL;
+					if(!DrawFontMulti((const uint8_t*)data, maxChunk)) {
+						ret = -EINVAL;
+						break;
+					}
 					mCursorX += maxChunk;
 					data += maxChunk;
 					todo -= maxChunk;
@@ -191,74 +371,829 @@ namespace embedded_drivers {
 			} else {
 write_single:
 				// A newline situation or special character needs care
-				if(!PutChar(*data))
-					return -EINVAL;
+				if(!PutChar(*data)) {
+					ret = -EINVAL;
+					break;
+				}
 				++data;
 				--todo;
 			}
 		}
-		return len;
+		--mRenderDeferred;
+		Present();
+		return ret;
 	}
 
-	void Ssd1306I2cDisplay::CursorSetPosition(unsigned col, unsigned page)
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::CursorSetPosition(unsigned col, unsigned page)
 	{
 		mCursorX = col;
 		mCursorY = page;
 		CursorApplyPosition();
+		Present();
 	}
 
-	void Ssd1306I2cDisplay::Init(void)
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::Init(void)
 	{
 		SSD1306DisplayCommand(0xd3, 0);		// disable display, start line := COM0
 		if(mFlipLongEdge)
 			SSD1306DisplayCommand(0xc8);	// COM output scan direction := inverted
 		else
 			SSD1306DisplayCommand(0xc0);	// COM output scan direction := normal mode
-		SSD1306DisplayCommand(0xda, 0x12);	// "alternative" COM pin config, disable COM left/right remap
+		SSD1306DisplayCommand(0xa8, uint8_t(cDisplayHeight-1));	// multiplex ratio := panel rows
+		SSD1306DisplayCommand(0xda, cComPins);	// COM pin config of the panel, disable COM left/right remap
 		SSD1306DisplayCommand(0x81, 127);	// set contrast for to 127
 		SSD1306DisplayCommand(0xa4);		// display on
 		SSD1306DisplayCommand(0xd5, 0x80);	// set OSC frequency: DIV=1, F=0b1000 (400 KHz?)
 		SSD1306DisplayCommand(0x8d, 0x14);	// enable charge pump regulator during display on
 		SSD1306DisplayCommand(0x20, 0);		// set horizontal addressing mode
 		On();
+		if(mFramebuffer) {
+			// display RAM content is unknown, so send all of it once
+			memset(mFramebuffer, 0, cFramebufferSize);
+			MarkAllDirty();
+			mViewPortY = 0;
+			CursorSetPosition(0, 0);
+			Flush();
+		} else {
+			Clear();
+		}
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::ShadowWrite(unsigned page, unsigned col, uint8_t const * data, unsigned len)
+	{
+		uint8_t * p = &mFramebuffer[page*cDisplayWidth + col];
+		unsigned first = len;
+		unsigned last = 0;
+
+		for(unsigned i = 0; i < len; ++i) {
+			if(p[i] != data[i]) {
+				p[i] = data[i];
+				if(first == len)
+					first = i;
+				last = i;
+			}
+		}
+		if(first < len)
+			MarkDirty(page, col+first, col+last);
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::ShadowFill(unsigned page, unsigned col, uint8_t value, unsigned len)
+	{
+		uint8_t * p = &mFramebuffer[page*cDisplayWidth + col];
+		unsigned first = len;
+		unsigned last = 0;
+
+		for(unsigned i = 0; i < len; ++i) {
+			if(p[i] != value) {
+				p[i] = value;
+				if(first == len)
+					first = i;
+				last = i;
+			}
+		}
+		if(first < len)
+			MarkDirty(page, col+first, col+last);
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::RasterSpan(unsigned page, unsigned col, unsigned len, uint8_t mask, DrawMode mode)
+	{
+		uint8_t * p = &mFramebuffer[page*cDisplayWidth + col];
+		unsigned first = len;
+		unsigned last = 0;
+
+		// four columns at a time
+		uint32_t const wide = mask * 0x01010101u;
+		unsigned i = 0;
+		for(; i + 4 <= len; i += 4) {
+			uint32_t old;
+			memcpy(&old, &p[i], 4);
+			uint32_t value;
+			switch(mode) {
+				case DrawClear:
+					value = old & ~wide;
+					break;
+				case DrawInvert:
+					value = old ^ wide;
+					break;
+				default:
+					value = old | wide;
+					break;
+			}
+			if(value == old)
+				continue;
+
+			uint8_t before[4];
+			memcpy(before, &p[i], 4);
+			memcpy(&p[i], &value, 4);
+			for(unsigned j = 0; j < 4; ++j) {
+				if(p[i+j] != before[j]) {
+					if(first == len)
+						first = i+j;
+					last = i+j;
+				}
+			}
+		}
+		for(; i < len; ++i) {
+			uint8_t value = RasterOp(p[i], mask, 0xff, mode);
+			if(value != p[i]) {
+				p[i] = value;
+				if(first == len)
+					first = i;
+				last = i;
+			}
+		}
+		if(first < len)
+			MarkDirty(page, col+first, col+last);
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::RasterBits(unsigned page, unsigned col, uint8_t const * bits, unsigned len, uint8_t mask, DrawMode mode)
+	{
+		uint8_t * p = &mFramebuffer[page*cDisplayWidth + col];
+		unsigned first = len;
+		unsigned last = 0;
+
+		for(unsigned i = 0; i < len; ++i) {
+			uint8_t value = RasterOp(p[i], mask, bits[i], mode);
+			if(value != p[i]) {
+				p[i] = value;
+				if(first == len)
+					first = i;
+				last = i;
+			}
+		}
+		if(first < len)
+			MarkDirty(page, col+first, col+last);
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::DrawPixel(int x, int y, DrawMode mode)
+	{
+		FillRect(x, y, 1, 1, mode);
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::DrawLine(int x0, int y0, int x1, int y1, DrawMode mode)
+	{
+		assert(mFramebuffer);
+
+		// Bresenham, collecting the pixels of each byte to change it once
+		int dx = std::abs(x1 - x0);
+		int dy = -std::abs(y1 - y0);
+		int sx = (x0 < x1) ? 1 : -1;
+		int sy = (y0 < y1) ? 1 : -1;
+		int err = dx + dy;
+		int col = -1;
+		int page = -1;
+		uint8_t bits = 0;
+
+		for(;;) {
+			if(x0 >= 0 && x0 < int(cDisplayWidth) && y0 >= 0 && y0 < int(cDisplayHeight)) {
+				if(x0 != col || y0/8 != page) {
+					if(bits)
+						RasterBits(ScreenPage(page*8), col, &bits, 1, bits, mode);
+					col = x0;
+					page = y0/8;
+					bits = 0;
+				}
+				bits |= 1 << (y0 % 8);
+			}
+			if(x0 == x1 && y0 == y1)
+				break;
+			int e2 = 2 * err;
+			if(e2 >= dy) {
+				err += dy;
+				x0 += sx;
+			}
+			if(e2 <= dx) {
+				err += dx;
+				y0 += sy;
+			}
+		}
+		if(bits)
+			RasterBits(ScreenPage(page*8), col, &bits, 1, bits, mode);
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::DrawRect(int x, int y, int w, int h, DrawMode mode)
+	{
+		// the sides leave out the corners, so inverting does not undo them
+		if(w <= 2 || h <= 2) {
+			FillRect(x, y, w, h, mode);
+			return;
+		}
+		FillRect(x, y, w, 1, mode);
+		FillRect(x, y+h-1, w, 1, mode);
+		FillRect(x, y+1, 1, h-2, mode);
+		FillRect(x+w-1, y+1, 1, h-2, mode);
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::FillRect(int x, int y, int w, int h, DrawMode mode)
+	{
+		assert(mFramebuffer);
+
+		int x0 = std::max(x, 0);
+		int x1 = std::min(x + w, int(cDisplayWidth));
+		int y0 = std::max(y, 0);
+		int y1 = std::min(y + h, int(cDisplayHeight));
+		if(x0 >= x1 || y0 >= y1)
+			return;
+
+		for(int row = y0 & ~7; row < y1; row += 8) {
+			unsigned top = std::max(y0 - row, 0);
+			unsigned bottom = std::min(y1 - row, 8);
+			uint8_t mask = (0xff << top) & (0xff >> (8 - bottom));
+			RasterSpan(ScreenPage(row), x0, x1 - x0, mask, mode);
+		}
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::DrawBitmap(int x, int y, uint8_t const * bitmap, int w, int h, DrawMode mode)
+	{
+		assert(mFramebuffer);
+
+		int x0 = std::max(x, 0);
+		int x1 = std::min(x + w, int(cDisplayWidth));
+		int y0 = std::max(y, 0);
+		int y1 = std::min(y + h, int(cDisplayHeight));
+		if(x0 >= x1 || y0 >= y1)
+			return;
+
+		int const pages = (h + 7) / 8;
+		for(int row = y0 & ~7; row < y1; row += 8) {
+			unsigned top = std::max(y0 - row, 0);
+			unsigned bottom = std::min(y1 - row, 8);
+			uint8_t mask = (0xff << top) & (0xff >> (8 - bottom));
+
+			// Bitmap rows row-y.. land on this page: two bitmap pages
+			// shifted together, a column at a time.
+			int shift = row - y;
+			int page = (shift >= 0) ? shift / 8 : -1;
+			shift -= 8 * page;
+			uint8_t * bits = TxData();
+			for(int col = x0; col < x1; ++col) {
+				unsigned source = col - x;
+				uint16_t pair = 0;
+				if(page >= 0)
+					pair = bitmap[page*w + source];
+				if(page + 1 < pages)
+					pair |= bitmap[(page+1)*w + source] << 8;
+				bits[col - x0] = pair >> shift;
+			}
+			RasterBits(ScreenPage(row), x0, bits, x1 - x0, mask, mode);
+		}
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	bool Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::DrawSpan(unsigned page, unsigned col, unsigned len,
+			void(*fill)(void * context, uint8_t * buffer, unsigned len), void * context)
+	{
+		assert(page < cVisiblePages && col + len <= cDisplayWidth);
+
+		unsigned const current = ScreenPage(page*8);
+		if(!mFramebuffer)
+			Window(current, current, col, col + len - 1);
+
+		bool ret = true;
+		while(len) {
+			unsigned chunk = (len < cTxCapacity) ? len : cTxCapacity;
+			fill(context, TxData(), chunk);
+			if(mFramebuffer)
+				ShadowWrite(current, col, TxData(), chunk);
+			else
+				ret = TxStaged(chunk) && ret;
+			col += chunk;
+			len -= chunk;
+		}
+
+		// text continues at the cursor, not after the span
+		if(!mFramebuffer)
+			CursorApplyPosition();
+		return ret;
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	unsigned Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::FlushWindow(unsigned first, unsigned & begin, unsigned & end)
+	{
+		unsigned const pages = cMaxPages;
+
+		// Extend the window over the following dirty pages as long as
+		// sending the clean bytes in between is cheaper than a new window.
+		begin = mDirtyBegin[first];
+		end = mDirtyEnd[first];
+		unsigned last = first;
+		while(last+1 < pages && IsDirty(last+1)) {
+			unsigned mergedBegin = std::min<unsigned>(begin, mDirtyBegin[last+1]);
+			unsigned mergedEnd = std::max<unsigned>(end, mDirtyEnd[last+1]);
+			unsigned rows = last - first + 1;
+			unsigned merged = (rows + 1) * (mergedEnd - mergedBegin + 1);
+			unsigned separate = rows * (end - begin + 1)
+				+ (mDirtyEnd[last+1] - mDirtyBegin[last+1] + 1) + cWindowCost;
+			if(merged > separate)
+				break;
+			begin = mergedBegin;
+			end = mergedEnd;
+			++last;
+		}
+		return last;
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	bool Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::Flush(void)
+	{
+		return FlushPart(~0u);
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	bool Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::FlushPart(unsigned bytes)
+	{
+		bool ret = true;
+		if(mScrollback)
+			ret = RenderTerminal();
+
+		if(!mFramebuffer)
+			return FlushCommands() && ret;
+
+		// the changes stay in the shadow for the next flush
+		if(mAsyncBusy)
+			return false;
+		if(mAsyncFailed) {
+			mAsyncFailed = false;
+			MarkAllDirty();
+		}
+
+		unsigned const pages = cMaxPages;
+		unsigned sent = 0;
+
+		for(unsigned first = 0; first < pages; ) {
+			if(!IsDirty(first)) {
+				++first;
+				continue;
+			}
+
+			unsigned begin, end;
+			unsigned last = FlushWindow(first, begin, end);
+
+			// only the pages within budget, the others keep their own
+			// dirty spans; at least one page row per call
+			unsigned const rowBytes = end-begin+1;
+			if(sent && sent + rowBytes > bytes)
+				return FlushCommands() && ret;
+			while(last > first && sent + (last-first+1)*rowBytes > bytes)
+				--last;
+
+			Window(first, last, begin, end);
+			for(unsigned page = first; page <= last; ++page) {
+				memcpy(TxData(), &mFramebuffer[page*cDisplayWidth + begin], end-begin+1);
+				if(!TxStaged(end-begin+1)) {
+					// what the panel shows is unknown, as after a failed
+					// asynchronous flush, so the next flush resends everything
+					MarkAllDirty();
+					return false;
+				}
+				sent += end-begin+1;
+				MarkClean(page);
+			}
+			first = last+1;
+		}
+
+		// the start line goes last, when the pages it shows are up to date
+		if(mViewPortDirty) {
+			SSD1306DisplayCommand(uint8_t(0x40 + mViewPortY));
+			mViewPortDirty = false;
+		}
+
+		return FlushCommands() && ret;
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	bool Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::SetAsyncTx(bool(*i2cTxAsync)(void * context, uint8_t address, uint8_t const * buffer, size_t len),
+			uint8_t * frontBuffer,
+			void(*completion)(void * context, bool success),
+			void * completionContext)
+	{
+		assert(mFramebuffer);
+
+		if(mAsyncBusy)
+			return false;
+		mI2cTxAsync = i2cTxAsync;
+		mFrontBuffer = frontBuffer;
+		mAsyncCompletion = completion;
+		mAsyncCompletionContext = completionContext;
+		return true;
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	bool Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::FlushAsync(void)
+	{
+		if(!mFramebuffer || !mFrontBuffer || mAsyncBusy)
+			return false;
+
+		if(mAsyncFailed) {
+			mAsyncFailed = false;
+			MarkAllDirty();
+		}
+
+		if(mScrollback)
+			RenderTerminal();
+
+		// commands are not part of the snapshot
+		if(!FlushCommands())
+			return false;
+
+		unsigned const pages = cMaxPages;
+		uint8_t * p = mFrontBuffer;
+		mAsyncCount = 0;
+		mAsyncNext = 0;
+
+		for(unsigned first = 0; first < pages; ) {
+			if(!IsDirty(first)) {
+				++first;
+				continue;
+			}
+
+			unsigned begin, end;
+			unsigned last = FlushWindow(first, begin, end);
+			uint8_t const window[] = {
+				0x21, uint8_t(cColumnOffset + begin), uint8_t(cColumnOffset + end),
+				0x22, uint8_t(first), uint8_t(last) };
+
+			for(unsigned page = first; page <= last; ++page) {
+				uint8_t * start = p;
+				if(page == first) {
+					for(uint8_t command : window) {
+						*p++ = 0x80;
+						*p++ = command;
+					}
+				}
+				*p++ = 0x40;
+				memcpy(p, &mFramebuffer[page*cDisplayWidth + begin], end-begin+1);
+				p += end-begin+1;
+				mAsyncTransfers[mAsyncCount++] = { uint16_t(start - mFrontBuffer), uint16_t(p - start) };
+				MarkClean(page);
+			}
+			first = last+1;
+		}
+
+		if(mViewPortDirty) {
+			uint8_t * start = p;
+			*p++ = 0x00;
+			*p++ = uint8_t(0x40 + mViewPortY);
+			mAsyncTransfers[mAsyncCount++] = { uint16_t(start - mFrontBuffer), uint16_t(p - start) };
+			mViewPortDirty = false;
+		}
+
+		assert(size_t(p - mFrontBuffer) <= cFrontBufferSize);
+
+		if(!mAsyncCount) {
+			if(mAsyncCompletion)
+				mAsyncCompletion(mAsyncCompletionContext, true);
+			return true;
+		}
+
+		mTxBytes += p - mFrontBuffer;
+		mTxTransfers += mAsyncCount;
+		mAsyncBusy = true;
+		AsyncTransfer const & transfer = mAsyncTransfers[mAsyncNext++];
+		if(!mI2cTxAsync(mI2cContext, mAddress, &mFrontBuffer[transfer.offset], transfer.len)) {
+			mAsyncBusy = false;
+			MarkAllDirty();
+			return false;
+		}
+		return true;
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	bool Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::HasChanges(void) const
+	{
+		if(mViewPortDirty)
+			return true;
+		for(unsigned page = 0; page < cMaxPages; ++page)
+			if(IsDirty(page))
+				return true;
+
+		// the terminal is drawn by the flush: lines that are not shown yet
+		// or whose text changed
+		if(mScrollback) {
+			unsigned const top = (mTermTop + mTermModulo - mTermBack) % mTermModulo;
+			if((top * cFontHeight) % cRamRows != mViewPortY)
+				return true;
+			for(unsigned row = 0; row < cLineCount; ++row) {
+				unsigned line = (top + row) % mTermModulo;
+				unsigned page = (line * cPagesPerLine) % cMaxPages;
+				if(mPageLine[page] != line || mLineDirtyBegin[page] <= mLineDirtyEnd[page])
+					return true;
+			}
+		}
+		return false;
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::TxComplete(bool success)
+	{
+		if(!mAsyncBusy)
+			return;
+
+		if(success && mAsyncNext < mAsyncCount) {
+			AsyncTransfer const & transfer = mAsyncTransfers[mAsyncNext++];
+			if(mI2cTxAsync(mI2cContext, mAddress, &mFrontBuffer[transfer.offset], transfer.len))
+				return;
+			success = false;
+		}
+
+		// the shadow may be in use, so resending is left to the next flush
+		if(!success)
+			mAsyncFailed = true;
+		mAsyncBusy = false;
+		if(mAsyncCompletion)
+			mAsyncCompletion(mAsyncCompletionContext, success);
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::SetScrollback(char * lines, unsigned lineCount)
+	{
+		assert(lineCount >= cLineCount);
+
+		// all RAM pages scroll into view eventually
+		mScrollback = NULL;
 		Clear();
+		ClearArea(cVisiblePages, cMaxPages - cVisiblePages, 0, cDisplayWidth);
+
+		mScrollback = lines;
+		mScrollbackLines = lineCount;
+		mTermModulo = lineCount * cMaxPages;
+		mTermTop = 0;
+		mTermBack = 0;
+		mTermHistory = 0;
+		memset(mScrollback, ' ', lineCount * cColumnCount);
+		for(unsigned page = 0; page < cMaxPages; ++page) {
+			mPageLine[page] = cBlankLine;
+			mPageExtent[page] = 0;
+			mLineDirtyBegin[page] = 0xff;
+			mLineDirtyEnd[page] = 0;
+		}
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	unsigned Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::ScrollBack(unsigned lines)
+	{
+		assert(mScrollback);
+
+		mTermBack = std::min(lines, mTermHistory);
+		Present();
+		return mTermBack;
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::TermWrite(unsigned line, unsigned col, char const * text, unsigned len)
+	{
+		char * p = TermText(line) + col;
+		unsigned first = len;
+		unsigned last = 0;
+
+		for(unsigned i = 0; i < len; ++i) {
+			if(p[i] != text[i]) {
+				p[i] = text[i];
+				if(first == len)
+					first = i;
+				last = i;
+			}
+		}
+		if(first < len)
+			TermMarkDirty(line, col+first, col+last);
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::TermFill(unsigned line, unsigned col, char c, unsigned len)
+	{
+		char * p = TermText(line) + col;
+		unsigned first = len;
+		unsigned last = 0;
+
+		for(unsigned i = 0; i < len; ++i) {
+			if(p[i] != c) {
+				p[i] = c;
+				if(first == len)
+					first = i;
+				last = i;
+			}
+		}
+		if(first < len)
+			TermMarkDirty(line, col+first, col+last);
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::TermMarkDirty(unsigned line, unsigned begin, unsigned end)
+	{
+		unsigned page = (line * cPagesPerLine) % cMaxPages;
+
+		// a line that is not shown is drawn in full when it comes into view
+		if(mPageLine[page] != line)
+			return;
+		if(mLineDirtyBegin[page] > mLineDirtyEnd[page]) {
+			mLineDirtyBegin[page] = begin;
+			mLineDirtyEnd[page] = end;
+		} else {
+			mLineDirtyBegin[page] = std::min<unsigned>(mLineDirtyBegin[page], begin);
+			mLineDirtyEnd[page] = std::max<unsigned>(mLineDirtyEnd[page], end);
+		}
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::TermScroll(void)
+	{
+		mTermTop = (mTermTop + 1) % mTermModulo;
+		if(mTermHistory + cLineCount < mScrollbackLines)
+			++mTermHistory;
+		memset(TermText(TermLine(cLineCount-1)), ' ', cColumnCount);
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	bool Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::RenderTerminal(void)
+	{
+		bool ret = true;
+		unsigned const top = (mTermTop + mTermModulo - mTermBack) % mTermModulo;
+
+		// the start line goes first, so it rides along with the first line drawn
+		unsigned y = (top * cFontHeight) % cRamRows;
+		if(y != mViewPortY)
+			SetViewPortY(y);
+
+		for(unsigned row = 0; row < cLineCount; ++row) {
+			unsigned line = (top + row) % mTermModulo;
+			unsigned page = (line * cPagesPerLine) % cMaxPages;
+			char const * text = TermText(line);
+
+			// Only columns up to the end of the old or the new text can differ.
+			unsigned extent = cColumnCount;
+			while(extent && text[extent-1] == ' ')
+				--extent;
+			bool drawn = true;
+			unsigned shown = extent;
+			for(unsigned i = 0; i < cPagesPerLine; ++i) {
+				unsigned current = (page + i) % cMaxPages;
+				drawn = drawn && mPageLine[current] == line;
+				shown = std::max<unsigned>(shown, mPageExtent[current]);
+				mPageLine[current] = line;
+				mPageExtent[current] = extent;
+			}
+			unsigned begin = 0;
+			unsigned end = shown;
+			if(drawn) {
+				if(mLineDirtyBegin[page] > mLineDirtyEnd[page])
+					continue;
+				begin = mLineDirtyBegin[page];
+				end = std::min<unsigned>(mLineDirtyEnd[page] + 1, shown);
+			}
+			mLineDirtyBegin[page] = 0xff;
+			mLineDirtyEnd[page] = 0;
+			if(begin < end)
+				ret = DrawText(page, begin * cFontWidth, (uint8_t const *)&text[begin], end - begin, false) && ret;
+		}
+
+		// rows below the last line that do not fit a whole line stay blank
+		for(unsigned i = cLineCount * cPagesPerLine; i < cVisiblePages; ++i) {
+			unsigned page = (top * cPagesPerLine + i) % cMaxPages;
+			if(mPageLine[page] == cBlankLine)
+				continue;
+			ClearArea(page, 1, 0, mPageExtent[page] * cFontWidth);
+			mPageLine[page] = cBlankLine;
+			mPageExtent[page] = 0;
+		}
+
+		return ret;
 	}
 
-	void Ssd1306I2cDisplay::CursorApplyPosition(void)
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::Command(std::initializer_list<uint8_t> command)
+	{
+		assert(command.size() <= cCommandCapacity);
+
+		mWindowQueued = false;
+		if(mCommandCount + command.size() > cCommandCapacity) {
+			// the queue is kept while a flush runs, so only a full one waits
+			while(mAsyncBusy)
+				;
+			FlushCommands();
+		}
+		memcpy(&mCommands[1 + mCommandCount], command.begin(), command.size());
+		mCommandCount += command.size();
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	bool Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::FlushCommands(void)
+	{
+		if(!mCommandCount)
+			return true;
+		// kept for the next call
+		if(mAsyncBusy)
+			return false;
+
+		unsigned len = 1 + mCommandCount;
+		mCommandCount = 0;
+		mWindowQueued = false;
+		return I2cTx(mCommands, len);
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	bool Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::I2cTxData(uint8_t const * buf, size_t len)
+	{
+		if(!mCommandCount)
+			return I2cTx(buf, len);
+
+		if(mCommandCount <= cInlineCommandLimit && len-1 <= cTxCapacity) {
+			memcpy(TxData(), buf+1, len-1);
+			return TxStaged(len-1);
+		}
+
+		bool ret = FlushCommands();
+		return I2cTx(buf, len) && ret;
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	bool Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::TxStaged(size_t len)
+	{
+		assert(len <= cTxCapacity);
+
+		// the queued commands are kept for the next call
+		if(mAsyncBusy)
+			return false;
+
+		bool ret = true;
+		uint8_t * start = TxData() - 1;
+		*start = 0x40;
+
+		if(mCommandCount > cInlineCommandLimit) {
+			ret = FlushCommands();
+		} else if(mCommandCount) {
+			start -= 2*mCommandCount;
+			for(unsigned i = 0; i < mCommandCount; ++i) {
+				start[2*i] = 0x80;
+				start[2*i+1] = mCommands[1 + i];
+			}
+			mCommandCount = 0;
+			mWindowQueued = false;
+		}
+
+		return I2cTx(start, (TxData() - start) + len) && ret;
+	}
+
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::CursorApplyPosition(void)
 	{
 		bool clearLine = false;
-		if(mCursorX >= mColumnCount) {
+		if(mCursorX >= cColumnCount) {
 			mCursorX = 0;
 			mCursorY += 1;
 		}
-		if(mCursorY >= mLineCount) {
-			mCursorY = mLineCount-1;
-			SetViewPortY(mViewPortY + mFontHeight);
+		if(mCursorY >= cLineCount) {
+			mCursorY = cLineCount-1;
+			if(!mScrollback)
+				SetViewPortY(mViewPortY + cFontHeight);
 			clearLine = true;
 		}
 
-		uint8_t col = mCursorX * mFontWidth;
-		uint8_t page = (mViewPortY/mFontHeight + mCursorY) % (mDisplayHeight / mFontHeight);
-		SSD1306DisplayCommand(0x22, page, page);
-		if(clearLine) {
-			SSD1306DisplayCommand(0x21, 0, uint8_t(mDisplayWidth-1));
-			for(unsigned i = 0; i < (mDisplayWidth / (mClearCommand.size()-1)); ++i)
-				I2cTx(mClearCommand);
+		if(mScrollback) {
+			// the new line is drawn from its text
+			if(clearLine)
+				TermScroll();
+			return;
 		}
-		SSD1306DisplayCommand(0x21, col, uint8_t(mDisplayWidth-1));
+
+		// the new line and the rows below it that do not fit a whole line
+		uint8_t col = mCursorX * cFontWidth;
+		uint8_t page = LinePage(mCursorY);
+		if(clearLine)
+			ClearArea(page, cVisiblePages - (cLineCount-1)*cPagesPerLine, 0, cDisplayWidth);
+
+		// Only single page lines are drawn at the address pointer, everything
+		// else uses the cursor to set up its own window.
+		if(mFramebuffer || cPagesPerLine > 1)
+			return;
+		if(!clearLine)
+			Window(page, page, col, cDisplayWidth-1);
+		else
+			ColumnWindow(col, cDisplayWidth-1);
 	}
 
-	void Ssd1306I2cDisplay::Test(void)
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	void Ssd1306I2cDisplayT<WIDTH, HEIGHT, FONT_WIDTH, FONT_HEIGHT>::Test(void)
 	{
 		unsigned i;
 
 		Clear();
 
-		for(i = 0; i < (2 * mColumnCount * mLineCount); ++i) {
-			if(0 == (i % mColumnCount)) {
+		for(i = 0; i < (2 * cColumnCount * cLineCount); ++i) {
+			if(0 == (i % cColumnCount)) {
 				PutChar(0x7f);
 				SleepMsecs(20);
-			} else if(0 == (i / mColumnCount)) {
+			} else if(0 == (i / cColumnCount)) {
 				PutChar('<');
 				SleepMsecs(20);
 			} else {
@@ -278,7 +1213,7 @@ write_single:
 		char buf[] = "Page X ";
 		for(unsigned page=0; page<5; ++page) {
 			buf[5] = '0'+page;
-			for(i=0; i<(mColumnCount * mLineCount / sizeof(buf)); ++i)
+			for(i=0; i<(cColumnCount * cLineCount / sizeof(buf)); ++i)
 				Write(buf, sizeof(buf));
 			SleepMsecs(500);
 		}
@@ -286,15 +1221,15 @@ write_single:
 		SleepMsecs(1000);
 		Clear();
 
-		for(int x=mColumnCount-3; x>=0; --x) {
-			int y = x%mLineCount;
+		for(int x=cColumnCount-3; x>=0; --x) {
+			int y = x%cLineCount;
 			CursorSetPosition(x,y);
 			PutChar('*');
 			PutChar('0'+y);
 			PutChar('*');
 			SleepMsecs(20);
 		}
-		CursorSetPosition(0, mLineCount-3);
+		CursorSetPosition(0, cLineCount-3);
 		const char newlineRemovesNextLine[] = "Newline removes next line?";
 		const char notThis[] = "\r\nNot this ->";
 		const char butThis[] = "\r\nBut this ->";
@@ -307,7 +1242,7 @@ write_single:
 		SleepMsecs(2000);
 		Clear();
 
-		for(i = 0; i < mLineCount*mColumnCount - 1; ++i)
+		for(i = 0; i < cLineCount*cColumnCount - 1; ++i)
 			PutChar('H');
 		CursorSetPosition(5, 2);
 		PutChar('\x02');
@@ -317,7 +1252,7 @@ write_single:
 		SleepMsecs(2000);
 		Clear();
 
-		for(i = 0; i < mLineCount*mColumnCount - 1; ++i)
+		for(i = 0; i < cLineCount*cColumnCount - 1; ++i)
 			PutChar('V');
 		CursorSetPosition(5, 2);
 		PutChar('\x03');
@@ -327,7 +1262,7 @@ write_single:
 		SleepMsecs(2000);
 		Clear();
 
-		for(i = 0; i < mLineCount*mColumnCount - 1; ++i)
+		for(i = 0; i < cLineCount*cColumnCount - 1; ++i)
 			PutChar('X');
 		CursorSetPosition(16, 1);
 		PutChar('\x04');
@@ -381,5 +1316,13 @@ write_single:
 		Clear();
 	}
 
+	template class Ssd1306I2cDisplayT<128, 64, 5, 8>;
+	template class Ssd1306I2cDisplayT<128, 32, 5, 8>;
+	template class Ssd1306I2cDisplayT<96, 16, 5, 8>;
+	template class Ssd1306I2cDisplayT<64, 48, 5, 8>;
+	template class Ssd1306I2cDisplayT<128, 64, 10, 16>;
+	template class Ssd1306I2cDisplayT<128, 64, 15, 24>;
+	template class Ssd1306I2cDisplayT<128, 32, 10, 16>;
+
 } // end of namespace embedded_drivers
 
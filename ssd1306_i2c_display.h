@@ -17,30 +17,145 @@
 
 #pragma once
 
-#include <alloca.h>
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstring>
 #include <cstdint>
-#include <vector>
+#include <initializer_list>
 
 namespace embedded_drivers {
 
-#define SSD1306DisplayCommand(...) I2cTx({0x00, __VA_ARGS__})
+#define SSD1306DisplayCommand(...) Command({__VA_ARGS__})
 
-	class Ssd1306I2cDisplay {
-		/* Driver for the Solomon Systech SSD1306 128x64 dotmatrix OLED display i2c controller. */
+	template<unsigned WIDTH, unsigned HEIGHT, unsigned FONT_WIDTH, unsigned FONT_HEIGHT>
+	class Ssd1306I2cDisplayT {
+		/* Driver for the Solomon Systech SSD1306 dotmatrix OLED display i2c controller,
+		 * for a panel of WIDTH x HEIGHT pixels and a font of FONT_WIDTH x FONT_HEIGHT.
+		 * Geometry is known at compile time, so all cursor arithmetic folds to constants.
+		 * Instantiated in ssd1306_i2c_display.cpp for the panels typedef'd below. */
+
+		static_assert(WIDTH <= 128 && HEIGHT <= 64 && HEIGHT % 8 == 0, "SSD1306 drives up to 128x64 pixels in pages of 8 rows");
+		static_assert(FONT_HEIGHT % 8 == 0 && FONT_HEIGHT <= HEIGHT, "glyphs are whole pages high");
+		static_assert(FONT_WIDTH > 0 && FONT_WIDTH <= WIDTH, "font must fit the panel");
 
 	public:
-		Ssd1306I2cDisplay(void * sleepMsecsContext,
+		static constexpr unsigned cDisplayWidth = WIDTH;
+		static constexpr unsigned cDisplayHeight = HEIGHT;
+		static constexpr unsigned cFontWidth = FONT_WIDTH;
+		static constexpr unsigned cFontHeight = FONT_HEIGHT;
+		static constexpr unsigned cColumnCount = WIDTH / FONT_WIDTH;
+		static constexpr unsigned cLineCount = HEIGHT / FONT_HEIGHT;
+
+		// Each glyph of `font_data` holds FONT_HEIGHT/8 page rows, top first,
+		// of FONT_WIDTH column bytes each, with the top pixel in the LSB.
+		// So a page row of a text line is a run of contiguous slices.
+		// `address` is 0x3c, or 0x3d for panels with SA0 tied high.
+		Ssd1306I2cDisplayT(void * sleepMsecsContext,
 				void(*sleepMsecs)(void * context, unsigned msecs),
 				void * mI2cContext,
 				bool(*i2cTx)(void * context, uint8_t address, uint8_t const * buffer, size_t len),
 				bool(*i2cRx)(void * context, uint8_t address, uint8_t * buffer, size_t len),
 				uint8_t const * font_data,
-				unsigned font_width,
-				unsigned font_height,
-				bool flipLongEdge=false);
-		~Ssd1306I2cDisplay(void);
+				bool flipLongEdge=false,
+				uint8_t * shadowFramebuffer=NULL,
+				uint8_t address=0x3c);
+		~Ssd1306I2cDisplayT(void);
+
+		// The controller has 8 pages of RAM whatever the panel height.
+		// Scrolling rotates the panel rows through all of them.
+		static constexpr unsigned cMaxPages = 8;
+
+		// Size of the optional shadow framebuffer passed to the constructor.
+		static constexpr size_t cFramebufferSize = WIDTH * cMaxPages;
+
+		// With a shadow framebuffer, all drawing only updates the shadow
+		// and records which column range of each page changed. Flush() then
+		// sends only those spans. Without one, everything is sent immediately,
+		// except for cursor moves that wait for the next data, see Command().
+		bool Flush(void);
+		// Same, but stops before a page row that would make it send more than
+		// `bytes` bytes of data, after at least one page row. So several
+		// displays on one bus can take turns, see Ssd1306Compositor.
+		// HasChanges() tells whether anything is left.
+		bool FlushPart(unsigned bytes);
+
+		// Size of the front buffer for asynchronous flushing: all pages,
+		// each with the control bytes and address window in front,
+		// and the start line command.
+		static constexpr size_t cFrontBufferSize = cFramebufferSize + cMaxPages * (1 + 2*6) + 2;
+
+		// Enables FlushAsync(), which needs a shadow framebuffer.
+		// `i2cTxAsync` starts a transfer and returns at once; the buffer stays
+		// untouched until the platform reports the end of the transfer with
+		// TxComplete(), e.g. from the event handler of the TWIM instance.
+		// `completion` is then called from there once the whole flush is sent.
+		// While a flush runs, nothing else waits for the bus: Flush() and
+		// the other calls that send return false, queued commands are kept
+		// for the next call, and this one fails. So no call blocks on a lost
+		// TWIM event, or in an interrupt above the TWIM IRQ priority. Only
+		// commands beyond the 16 byte queue wait for the flush to finish,
+		// e.g. many of On(), ColorInvert() and the like while it runs.
+		bool SetAsyncTx(bool(*i2cTxAsync)(void * context, uint8_t address, uint8_t const * buffer, size_t len),
+				uint8_t * frontBuffer,
+				void(*completion)(void * context, bool success),
+				void * completionContext);
+
+		// Copies the dirty spans into the front buffer and starts sending them,
+		// one transfer per page row of at most 141 bytes. Drawing into the
+		// shadow continues meanwhile and is sent by the next flush.
+		// Returns false if a flush is still running or could not be started.
+		// If there is nothing to send, `completion` is called right away.
+		bool FlushAsync(void);
+		// Reports the end of a transfer started by FlushAsync(). Must not be
+		// called from within i2cTxAsync. Calls outside of a flush are ignored,
+		// so the event handler may also see the synchronous transfers.
+		void TxComplete(bool success);
+		bool IsFlushing(void)		{ return mAsyncBusy; }
+
+		// Whether the shadow holds changes for the next flush.
+		bool HasChanges(void) const;
+
+		// Bytes and transfers handed to i2cTx / i2cTxAsync so far,
+		// for bus load statistics.
+		uint32_t TxBytes(void) const		{ return mTxBytes; }
+		uint32_t TxTransfers(void) const	{ return mTxTransfers; }
+
+		// Terminal mode: the text of the screen and of the last lines that
+		// scrolled off is kept in `lines`, a ring of `lineCount` lines of
+		// cColumnCount (WIDTH / FONT_WIDTH) characters each, holding at least
+		// one screen, i.e. cLineCount lines.
+		// The screen is then drawn from that text: a wrap only moves the start
+		// line and redraws the newly exposed line up to where either its old
+		// or its new text ends, and lines that scroll off before they are
+		// shown are never sent. Enabling it clears the screen.
+		void SetScrollback(char * lines, unsigned lineCount);
+		// Shows the text `lines` lines above the current one, 0 for the live
+		// screen. Only the lines that come into view are redrawn.
+		// Returns the offset, limited to the available history.
+		unsigned ScrollBack(unsigned lines);
+
+		// Raster graphics in panel pixels, from the top left of the screen,
+		// clipped to the panel. They need the shadow framebuffer and only
+		// draw into it, whole bytes of 8 rows at a time, so Flush() sends
+		// just the columns that changed. DrawCopy makes the pixels of a bitmap
+		// replace the screen, the other modes apply only its set pixels.
+		enum DrawMode { DrawClear, DrawSet, DrawInvert, DrawCopy };
+		void DrawPixel(int x, int y, DrawMode mode = DrawSet);
+		void DrawLine(int x0, int y0, int x1, int y1, DrawMode mode = DrawSet);
+		void DrawRect(int x, int y, int w, int h, DrawMode mode = DrawSet);
+		void FillRect(int x, int y, int w, int h, DrawMode mode = DrawSet);
+		// `bitmap` is `w` x `h` pixels in the page layout of the display:
+		// (h+7)/8 rows of w column bytes, the top pixel in the LSB.
+		// `y` needs not be a multiple of 8.
+		void DrawBitmap(int x, int y, uint8_t const * bitmap, int w, int h, DrawMode mode = DrawCopy);
+
+		// Replaces `len` bytes of screen page `page` from column `col` on.
+		// `fill` produces them in chunks, straight into the transfer buffer
+		// or, with a shadow framebuffer, into the shadow, so the caller needs
+		// no buffer of its own, see Ssd1306Animation.
+		bool DrawSpan(unsigned page, unsigned col, unsigned len,
+				void(*fill)(void * context, uint8_t * buffer, unsigned len), void * context);
 
 		void Clear(void);
 		void ClearColumnsAfterCursor(bool fixCursorPosition = true);
@@ -48,14 +163,16 @@ namespace embedded_drivers {
 		void ClearAfterCursor(bool resetCursorToNull = true);
 		bool PutChar(char const c);
 		bool Puts(char const *str);
+		// Sent directly, text that covers a rectangle of whole glyphs, also
+		// across line wraps and "\r\n", goes out in a single window.
 		int Write(char const *data, int const len);
 
-		void Off(void)			{ SSD1306DisplayCommand(0xae); };
-		void On(void)			{ SSD1306DisplayCommand(0xaf); };
-		void ColorNormal(void)		{ SSD1306DisplayCommand(0xa6); };
-		void ColorInvert(void)		{ SSD1306DisplayCommand(0xa7); };
-		void HideDisplay(void)		{ SSD1306DisplayCommand(0xa5); };
-		void ShowDisplay(void)		{ SSD1306DisplayCommand(0xa4); };
+		void Off(void)			{ SSD1306DisplayCommand(0xae); FlushCommands(); };
+		void On(void)			{ SSD1306DisplayCommand(0xaf); FlushCommands(); };
+		void ColorNormal(void)		{ SSD1306DisplayCommand(0xa6); FlushCommands(); };
+		void ColorInvert(void)		{ SSD1306DisplayCommand(0xa7); FlushCommands(); };
+		void HideDisplay(void)		{ SSD1306DisplayCommand(0xa5); FlushCommands(); };
+		void ShowDisplay(void)		{ SSD1306DisplayCommand(0xa4); FlushCommands(); };
 
 		void CursorSetPosition(unsigned col, unsigned page);
 
@@ -64,25 +181,108 @@ namespace embedded_drivers {
 		void Test(void);
 
 	private:
-		unsigned const mDisplayWidth;
-		unsigned const mDisplayHeight;
+		static constexpr unsigned cFontFaceSize = FONT_WIDTH * FONT_HEIGHT / 8;
+		static constexpr unsigned cPagesPerLine = FONT_HEIGHT / 8;
+		static constexpr unsigned cVisiblePages = HEIGHT / 8;
+		static constexpr unsigned cRamRows = cMaxPages * 8;
+
+		// COM pin configuration (0xda) of the panel wiring: 64 and 48 row panels
+		// use every COM line ("alternative"), shorter ones every other line.
+		static constexpr uint8_t cComPins = (HEIGHT > 32) ? 0x12 : 0x02;
+		// 64x48 panels are wired to the middle of the 128 RAM columns.
+		static constexpr unsigned cColumnOffset = (WIDTH == 64 && HEIGHT == 48) ? 32 : 0;
+
 		uint8_t const * mFontData;
-		unsigned const mFontWidth;
-		unsigned const mFontHeight;
-		unsigned const mFontFaceSize;
-		unsigned const mColumnCount;
-		unsigned const mLineCount;
 		bool const mFlipLongEdge;
 		uint8_t const mAddress;
-		std::vector<uint8_t> const mClearCommand;
 
 		unsigned mCursorX;
 		unsigned mCursorY;
 		unsigned mViewPortY;
 
+		// Shadow of the display RAM, in page layout, or NULL.
+		// Per page, columns mDirtyBegin..mDirtyEnd differ from the display.
+		// Bus bytes of opening a new address window, to decide whether
+		// to merge adjacent dirty pages into one window.
+		static const unsigned cWindowCost = 8;
+		uint8_t * const mFramebuffer;
+		uint8_t mDirtyBegin[cMaxPages];
+		uint8_t mDirtyEnd[cMaxPages];
+		bool mViewPortDirty;
+
+		// Asynchronous flush: the transfers of the running flush are at
+		// mFrontBuffer, mAsyncNext is the next one to send. While mAsyncBusy,
+		// synchronous transfers fail and leave the queued commands, only a
+		// full command queue waits for the flush to finish. A failed flush
+		// leaves mAsyncFailed, and the next flush resends everything.
+		struct AsyncTransfer {
+			uint16_t offset;
+			uint16_t len;
+		};
+		uint8_t * mFrontBuffer;
+		AsyncTransfer mAsyncTransfers[cMaxPages + 1];
+		unsigned mAsyncCount;
+		unsigned mAsyncNext;
+		std::atomic<bool> mAsyncBusy;
+		std::atomic<bool> mAsyncFailed;
+		bool(*mI2cTxAsync)(void * context, uint8_t address, uint8_t const * buffer, size_t len);
+		void(*mAsyncCompletion)(void * context, bool success);
+		void * mAsyncCompletionContext;
+
+		// Terminal mode, see SetScrollback(). Lines are numbered modulo
+		// mTermModulo, a multiple of both ring and page count, so line n is
+		// kept in ring slot n % mScrollbackLines and starts on page
+		// n*cPagesPerLine % pages. mTermTop is the line at the top of the
+		// live screen, the view is mTermBack lines above it. Page p shows
+		// line mPageLine[p] drawn up to column mPageExtent[p], or is blank
+		// if cBlankLine. Columns mLineDirtyBegin..End of a line changed,
+		// kept at its first page.
+		static constexpr unsigned cBlankLine = ~0u;
+		char * mScrollback;
+		unsigned mScrollbackLines;
+		unsigned mTermModulo;
+		unsigned mTermTop;
+		unsigned mTermBack;
+		unsigned mTermHistory;
+		unsigned mPageLine[cMaxPages];
+		uint8_t mPageExtent[cMaxPages];
+		uint8_t mLineDirtyBegin[cMaxPages];
+		uint8_t mLineDirtyEnd[cMaxPages];
+		// Write() draws the screen once at the end, not for each part.
+		unsigned mRenderDeferred;
+
+		// Commands are collected after the 0x00 control byte in mCommands
+		// and sent as one transfer before the next data, or on FlushCommands().
+		// If few enough are pending, they are instead sent in the data transfer
+		// itself, each behind a 0x80 control byte, followed by 0x40 and the data.
+		// That costs one more byte per command byte but saves a transfer,
+		// which costs about cTransactionCost bytes of bus and driver time
+		// (START, address, STOP and the per-transfer latency of the driver).
+		// So cursor moves (6 bytes) and scrolls (7 bytes) ride along with data.
+		static const unsigned cCommandCapacity = 16;
+		static const unsigned cTransactionCost = 6;
+		static const unsigned cInlineCommandLimit = 1 + cTransactionCost;
+		uint8_t mCommands[1 + cCommandCapacity];
+		unsigned mCommandCount;
+		// The last 6 queued bytes are a window, see Window().
+		bool mWindowQueued;
+
+		// Staging buffer for data transfers, so the hot path never allocates.
+		// Data is staged at TxData(), behind room for the 0x40 control byte
+		// and for inlined commands in front of it, which saves a copy.
+		// It holds one full page row, the most that is sent at once.
+		static const unsigned cTxHeadroom = 2*cInlineCommandLimit + 1;
+		static const unsigned cTxCapacity = 128;
+		uint8_t mTxBuffer[cTxHeadroom + cTxCapacity];
+
+		// Data transfer of zeros, for clearing.
+		static uint8_t const cClearBlock[1 + 64];
+
 		void * mSleepMsecsContext;
 		void(*mSleepMsecs)(void * context, unsigned msecs);
 		void * mI2cContext;
+		uint32_t mTxBytes;
+		uint32_t mTxTransfers;
 		bool(*mI2cTx)(void * context, uint8_t address, uint8_t const * buffer, size_t len);
 		bool(*mI2cRx)(void * context, uint8_t address, uint8_t * buffer, size_t len);
 
@@ -90,53 +290,226 @@ namespace embedded_drivers {
 
 		void CursorApplyPosition(void);
 
+		// First display RAM page that shows text line `line`. The pages of
+		// a line follow it, wrapping around at the end of the RAM.
+		unsigned LinePage(unsigned line)
+		{
+			return ((mViewPortY + line*cFontHeight) % cRamRows) / 8;
+		}
+
+		bool IsDirty(unsigned page) const
+		{
+			return mDirtyBegin[page] <= mDirtyEnd[page];
+		}
+
+		void MarkDirty(unsigned page, unsigned begin, unsigned end)
+		{
+			if(!IsDirty(page)) {
+				mDirtyBegin[page] = begin;
+				mDirtyEnd[page] = end;
+			} else {
+				mDirtyBegin[page] = std::min<unsigned>(mDirtyBegin[page], begin);
+				mDirtyEnd[page] = std::max<unsigned>(mDirtyEnd[page], end);
+			}
+		}
+
+		void MarkClean(unsigned page)
+		{
+			mDirtyBegin[page] = 0xff;
+			mDirtyEnd[page] = 0;
+		}
+
+		void MarkAllDirty(void)
+		{
+			for(unsigned page = 0; page < cMaxPages; ++page)
+				MarkDirty(page, 0, cDisplayWidth-1);
+			mViewPortDirty = true;
+		}
+
+		// Returns the last page of the address window to send for dirty page
+		// `first`, and its column range in `begin` and `end`.
+		unsigned FlushWindow(unsigned first, unsigned & begin, unsigned & end);
+
+		// Copy to / fill the shadow framebuffer, marking changed bytes dirty.
+		void ShadowWrite(unsigned page, unsigned col, uint8_t const * data, unsigned len);
+		void ShadowFill(unsigned page, unsigned col, uint8_t value, unsigned len);
+
+		// Shadow page that shows row `y` of the screen.
+		unsigned ScreenPage(unsigned y)
+		{
+			return (mViewPortY/8 + y/8) % cMaxPages;
+		}
+
+		static uint8_t RasterOp(uint8_t old, uint8_t mask, uint8_t bits, DrawMode mode)
+		{
+			switch(mode) {
+				case DrawClear:
+					return old & ~(mask & bits);
+				case DrawSet:
+					return old | (mask & bits);
+				case DrawInvert:
+					return old ^ (mask & bits);
+				default:
+					return (old & ~mask) | (mask & bits);
+			}
+		}
+
+		// Applies `mode` to the pixels in `mask` of `len` shadow bytes, with
+		// all bits set resp. with the bits in `bits`, marking changes dirty.
+		void RasterSpan(unsigned page, unsigned col, unsigned len, uint8_t mask, DrawMode mode);
+		void RasterBits(unsigned page, unsigned col, uint8_t const * bits, unsigned len, uint8_t mask, DrawMode mode);
+
+		char * TermText(unsigned line)
+		{
+			return &mScrollback[(line % mScrollbackLines) * cColumnCount];
+		}
+
+		// Line of the text at row `row` of the live screen.
+		unsigned TermLine(unsigned row)
+		{
+			return (mTermTop + row) % mTermModulo;
+		}
+
+		// Stores text in a line, marking changes of shown lines dirty.
+		void TermWrite(unsigned line, unsigned col, char const * text, unsigned len);
+		void TermFill(unsigned line, unsigned col, char c, unsigned len);
+		void TermMarkDirty(unsigned line, unsigned begin, unsigned end);
+		void TermScroll(void);
+		// Draws the lines of the view that changed, into the shadow
+		// framebuffer if there is one.
+		bool RenderTerminal(void);
+
+		// In direct terminal mode, shows what was written so far.
+		void Present(void)
+		{
+			if(mScrollback && !mFramebuffer && !mRenderDeferred)
+				Flush();
+		}
+
+		uint8_t const * Glyph(uint8_t c)
+		{
+			return &mFontData[cFontFaceSize * (c - ' ')];
+		}
+
+		// Draws `len` characters at column `col` of the line starting at
+		// page `page`, into the shadow framebuffer if there is one.
+		// Otherwise one address window covers all pages of the line, and each
+		// page row goes out as one transfer. Lines of a single page may instead
+		// use the window the cursor left, if `cursorWindow`.
+		bool DrawText(unsigned page, unsigned col, uint8_t const * text, unsigned len, bool cursorWindow);
+
 		bool DrawFont(unsigned c)
 		{
-			unsigned const tx_size = 1+mFontFaceSize;
-			uint8_t * buf = static_cast<uint8_t*>(alloca(tx_size));
-			buf[0] = 0x40;
-			memcpy(buf+1, &mFontData[c*mFontFaceSize], mFontFaceSize);
-			return I2cTx(buf, tx_size);
+			uint8_t text = uint8_t(c + ' ');
+			return DrawFontMulti(&text, 1);
 		}
 
+		// Without shadow or terminal, draws the text at `data` that covers
+		// a rectangle of whole glyphs from the cursor on, as one window:
+		// runs of the same length in the same column of consecutive lines,
+		// split by line wraps or "\r\n". A bare "\n" keeps the column
+		// after the run, so it ends the rectangle. Returns the bytes used,
+		// 0 if that is not at least two glyphs.
+		int WriteRun(char const * data, int len);
+
 		bool DrawFontMulti(uint8_t const * data, size_t len)
 		{
-			assert(len <= mColumnCount);
+			assert(mCursorX + len <= cColumnCount);
 
-			unsigned const tx_size = 1 + len * mFontFaceSize;
-			std::vector<uint8_t> buf(tx_size);
-			uint8_t *p;
-			unsigned i;
-
-			buf[0] = 0x40;
-			for(i=0, p=buf.data()+1 ; i<len ; ++i, p+=mFontFaceSize, ++data) {
-				unsigned offset = mFontFaceSize * (*data - ' ');
-				memcpy(p, &mFontData[offset], mFontFaceSize);
+			if(mScrollback) {
+				TermWrite(TermLine(mCursorY), mCursorX, (char const *)data, len);
+				return true;
 			}
-			return I2cTx(buf.data(), tx_size);
+
+			return DrawText(LinePage(mCursorY), mCursorX*cFontWidth, data, len, true);
 		}
 
+		// Queues the column window `begin`..`end` of the panel.
+		void ColumnWindow(unsigned begin, unsigned end)
+		{
+			SSD1306DisplayCommand(0x21, uint8_t(cColumnOffset + begin), uint8_t(cColumnOffset + end));
+		}
+
+		// Queues the window of pages `first`..`last`, columns `begin`..`end`.
+		// A window queued right before it is dropped, as this one overrides
+		// it anyway, e.g. for the two cursor moves of "\r\n".
+		void Window(unsigned first, unsigned last, unsigned begin, unsigned end)
+		{
+			if(mWindowQueued)
+				mCommandCount -= 6;
+			SSD1306DisplayCommand(0x22, uint8_t(first), uint8_t(last));
+			ColumnWindow(begin, end);
+			mWindowQueued = true;
+		}
+
+		// Clears columns `col`..`col+width-1` of `pages` pages from `page` on,
+		// wrapping around at the end of the RAM, or of the shadow.
+		void ClearArea(unsigned page, unsigned pages, unsigned col, unsigned width);
+
 		bool I2cTx(uint8_t const * buf, size_t len)
 		{
+			if(mAsyncBusy)
+				return false;
+			mTxBytes += len;
+			++mTxTransfers;
 			return mI2cTx(mI2cContext, mAddress, buf, len);
 		}
 
-		bool I2cTx(std::vector<uint8_t> const & payload)
+		// Queues one command with its arguments.
+		void Command(std::initializer_list<uint8_t> command);
+		// Sends all queued commands.
+		bool FlushCommands(void);
+		// Sends `len` bytes at `buf`, which start with the 0x40 control byte,
+		// preceded by the queued commands.
+		bool I2cTxData(uint8_t const * buf, size_t len);
+
+		uint8_t * TxData(void)
 		{
-			return mI2cTx(mI2cContext, mAddress, &payload[0], payload.size());
+			return &mTxBuffer[cTxHeadroom];
 		}
 
+		// Sends `len` bytes staged at TxData(), preceded by the queued commands.
+		bool TxStaged(size_t len);
+
 		void SetViewPortY(unsigned y)
 		{
-			mViewPortY = y % mDisplayHeight;
-			SSD1306DisplayCommand(uint8_t(0x40 + mViewPortY));
+			y %= cRamRows;
+			if(mFramebuffer) {
+				mViewPortDirty |= (y != mViewPortY);
+				mViewPortY = y;
+			} else {
+				mViewPortY = y;
+				SSD1306DisplayCommand(uint8_t(0x40 + mViewPortY));
+			}
 		}
 
 		void SleepMsecs(unsigned msecs)
 		{
+			// show what was drawn before waiting
+			Flush();
 			mSleepMsecs(mSleepMsecsContext, msecs);
 		}
 	};
 
+	// Panels with 5x8 fonts like font_tama_mini02.
+	typedef Ssd1306I2cDisplayT<128, 64, 5, 8> Ssd1306I2cDisplay;
+	typedef Ssd1306I2cDisplayT<128, 32, 5, 8> Ssd1306I2cDisplay128x32;
+	typedef Ssd1306I2cDisplayT<96, 16, 5, 8> Ssd1306I2cDisplay96x16;
+	typedef Ssd1306I2cDisplayT<64, 48, 5, 8> Ssd1306I2cDisplay64x48;
+
+	extern template class Ssd1306I2cDisplayT<128, 64, 5, 8>;
+	extern template class Ssd1306I2cDisplayT<128, 32, 5, 8>;
+	extern template class Ssd1306I2cDisplayT<96, 16, 5, 8>;
+	extern template class Ssd1306I2cDisplayT<64, 48, 5, 8>;
+
+	// Panels with large fonts, e.g. for readouts.
+	typedef Ssd1306I2cDisplayT<128, 64, 10, 16> Ssd1306I2cDisplay128x64Font10x16;
+	typedef Ssd1306I2cDisplayT<128, 64, 15, 24> Ssd1306I2cDisplay128x64Font15x24;
+	typedef Ssd1306I2cDisplayT<128, 32, 10, 16> Ssd1306I2cDisplay128x32Font10x16;
+
+	extern template class Ssd1306I2cDisplayT<128, 64, 10, 16>;
+	extern template class Ssd1306I2cDisplayT<128, 64, 15, 24>;
+	extern template class Ssd1306I2cDisplayT<128, 32, 10, 16>;
+
 } // end of namespace embedded_drivers
 
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Micro-benchmark harness of the bench_* programs.
+//
+// Each Run() times a function that processes a fixed number of bits per
+// call, until at least cMinSeconds passed. Results are printed as a table
+// and, if requested on the command line, also written as CSV and/or JSON:
+//
+//   bench_lfsr --csv=bench_lfsr.csv --json=bench_lfsr.json
+
+// Stores a benchmark result, so the compiler can not optimize it away.
+static volatile uint64_t bench_sink;
+
+template <class T>
+inline void bench_keep(T value)
+{
+	bench_sink = static_cast<uint64_t>(value);
+}
+
+class Bench {
+public:
+	static constexpr double cMinSeconds = 0.05;
+
+	struct Result {
+		std::string mName;
+		std::string mVariant;
+		unsigned mCount;
+		double mNsPerCall;
+		double mNsPerBit;
+		double mBytesPerSecond;
+	};
+
+	Bench(int argc, char ** argv)
+	{
+		for (int i = 1; i < argc; ++i) {
+			if (!strncmp(argv[i], "--csv=", 6))
+				mCsvPath = argv[i] + 6;
+			else if (!strncmp(argv[i], "--json=", 7))
+				mJsonPath = argv[i] + 7;
+			else
+				fprintf(stderr, "ignoring unknown argument %s\n", argv[i]);
+		}
+		printf("%-24s %-16s %8s %12s %10s %12s\n",
+				"benchmark", "variant", "count", "ns/call", "ns/bit", "MB/s");
+	}
+
+	~Bench()
+	{
+		if (!mCsvPath.empty())
+			WriteCsv();
+		if (!mJsonPath.empty())
+			WriteJson();
+	}
+
+	// Times `call`, which processes `bits` bits per call.
+	// `count` is the size parameter of the benchmarked function, if any.
+	template <class F>
+	void Run(std::string const & name, std::string const & variant,
+			unsigned count, double bits, F call)
+	{
+		typedef std::chrono::steady_clock Clock;
+
+		call();	// warm up
+
+		uint64_t calls = 1;
+		double seconds = 0;
+		while (true) {
+			Clock::time_point start = Clock::now();
+			for (uint64_t i = 0; i < calls; ++i)
+				call();
+			seconds = std::chrono::duration<double>(Clock::now() - start).count();
+			if (seconds >= cMinSeconds)
+				break;
+			calls *= (seconds > cMinSeconds / 64) ? 2 : 16;
+		}
+
+		Result result;
+		result.mName = name;
+		result.mVariant = variant;
+		result.mCount = count;
+		result.mNsPerCall = 1e9 * seconds / calls;
+		result.mNsPerBit = result.mNsPerCall / bits;
+		result.mBytesPerSecond = bits / 8 * calls / seconds;
+		mResults.push_back(result);
+
+		printf("%-24s %-16s %8u %12.2f %10.4f %12.2f\n", name.c_str(), variant.c_str(),
+				count, result.mNsPerCall, result.mNsPerBit, result.mBytesPerSecond / 1e6);
+		fflush(stdout);
+	}
+
+private:
+	std::string mCsvPath;
+	std::string mJsonPath;
+	std::vector<Result> mResults;
+
+	void WriteCsv(void)
+	{
+		FILE * file = fopen(mCsvPath.c_str(), "w");
+		if (!file) {
+			perror(mCsvPath.c_str());
+			return;
+		}
+		fprintf(file, "benchmark,variant,count,ns_per_call,ns_per_bit,bytes_per_second\n");
+		for (Result const & r : mResults)
+			fprintf(file, "%s,%s,%u,%.4f,%.6f,%.1f\n", r.mName.c_str(), r.mVariant.c_str(),
+					r.mCount, r.mNsPerCall, r.mNsPerBit, r.mBytesPerSecond);
+		fclose(file);
+	}
+
+	void WriteJson(void)
+	{
+		FILE * file = fopen(mJsonPath.c_str(), "w");
+		if (!file) {
+			perror(mJsonPath.c_str());
+			return;
+		}
+		fprintf(file, "[\n");
+		for (size_t i = 0; i < mResults.size(); ++i) {
+			Result const & r = mResults[i];
+			fprintf(file, "  {\"benchmark\": \"%s\", \"variant\": \"%s\", \"count\": %u, "
+					"\"ns_per_call\": %.4f, \"ns_per_bit\": %.6f, \"bytes_per_second\": %.1f}%s\n",
+					r.mName.c_str(), r.mVariant.c_str(), r.mCount, r.mNsPerCall,
+					r.mNsPerBit, r.mBytesPerSecond, (i + 1 < mResults.size()) ? "," : "");
+		}
+		fprintf(file, "]\n");
+		fclose(file);
+	}
+};
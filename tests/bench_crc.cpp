@@ -0,0 +1,49 @@
+#include "embedded_drivers/crc.h"
+#include "bench.h"
+
+#include <vector>
+
+using namespace embedded_drivers;
+
+// Measures CRC throughput, bitwise against slice-by-1/4/8 tables.
+
+static const size_t cBufferSize = 1 << 16;
+
+template <class T, unsigned int WIDTH, T POLY, T INIT, bool REFLECTED, T XOROUT>
+void bench_crc(Bench & bench, char const * name)
+{
+	std::vector<uint8_t> buffer(cBufferSize);
+	LfsrDefault32().Fill(buffer.data(), buffer.size());
+
+	Crc<T, WIDTH, POLY, INIT, REFLECTED, XOROUT, 1> crc1;
+	Crc<T, WIDTH, POLY, INIT, REFLECTED, XOROUT, 4> crc4;
+	Crc<T, WIDTH, POLY, INIT, REFLECTED, XOROUT, 8> crc8;
+
+	bench.Run(name, "bitwise", cBufferSize, 8 * cBufferSize, [&]() {
+			crc1.UpdateBitwise(buffer.data(), buffer.size());
+			bench_keep(crc1.Get());
+		});
+	bench.Run(name, "slice-by-1", cBufferSize, 8 * cBufferSize, [&]() {
+			crc1.Update(buffer.data(), buffer.size());
+			bench_keep(crc1.Get());
+		});
+	bench.Run(name, "slice-by-4", cBufferSize, 8 * cBufferSize, [&]() {
+			crc4.Update(buffer.data(), buffer.size());
+			bench_keep(crc4.Get());
+		});
+	bench.Run(name, "slice-by-8", cBufferSize, 8 * cBufferSize, [&]() {
+			crc8.Update(buffer.data(), buffer.size());
+			bench_keep(crc8.Get());
+		});
+}
+
+int main(int argc, char ** argv)
+{
+	Bench bench(argc, argv);
+
+	bench_crc<uint8_t, 8, 0x31, 0x00, false, 0x00>(bench, "Crc8Si7020");
+	bench_crc<uint16_t, 16, 0x1021, 0xffff, false, 0x0000>(bench, "Crc16CcittFalse");
+	bench_crc<uint16_t, 16, 0x8005, 0xffff, true, 0x0000>(bench, "Crc16Modbus");
+	bench_crc<uint32_t, 32, 0x04c11db7, 0xffffffff, true, 0xffffffff>(bench, "Crc32");
+	return 0;
+}
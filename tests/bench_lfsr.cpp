@@ -0,0 +1,68 @@
+#include "embedded_drivers/lfsr.h"
+#include "bench.h"
+
+#include <vector>
+
+using namespace embedded_drivers;
+
+// Measures ns/bit and bytes/s of every LfsrDefaultN, for Iterate() and
+// IterateTable() at several counts and for bulk Fill().
+
+static const size_t cFillSize = 4096;
+
+template <class LFSR>
+void bench_lfsr(Bench & bench, char const * name)
+{
+	typedef typename LFSR::BaseType BaseType;
+	const unsigned max_count = 8 * sizeof(BaseType);
+
+	for (unsigned count : { 1, 8, 16, 32, 64, 128 }) {
+		if (count > max_count)
+			break;
+
+		LFSR lfsr;
+		bench.Run(name, "Iterate", count, count, [&]() {
+				bench_keep(lfsr.Iterate(count));
+			});
+		bench.Run(name, "IterateTable", count, count, [&]() {
+				bench_keep(lfsr.IterateTable(count));
+			});
+	}
+
+	std::vector<uint8_t> buffer(cFillSize);
+	LFSR lfsr;
+	bench.Run(name, "Fill", cFillSize, 8 * cFillSize, [&]() {
+			lfsr.Fill(buffer.data(), buffer.size());
+			bench_keep(buffer[0]);
+		});
+
+	if constexpr (LFSR::cMaximalPeriod >= LfsrBitSliced<LFSR>::cLanes) {
+		LfsrBitSliced<LFSR> sliced;
+		bench.Run(name, "BitSliced::Fill", cFillSize, 8 * cFillSize, [&]() {
+				sliced.Fill(buffer.data(), buffer.size());
+				bench_keep(buffer[0]);
+			});
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	Bench bench(argc, argv);
+
+	bench_lfsr<LfsrDefault4>(bench, "LfsrDefault4");
+	bench_lfsr<LfsrDefault8>(bench, "LfsrDefault8");
+	bench_lfsr<LfsrDefault9>(bench, "LfsrDefault9");
+	bench_lfsr<LfsrDefault10>(bench, "LfsrDefault10");
+	bench_lfsr<LfsrDefault15>(bench, "LfsrDefault15");
+	bench_lfsr<LfsrFibonacci>(bench, "LfsrFibonacci");
+	bench_lfsr<LfsrDefault16>(bench, "LfsrDefault16");
+	bench_lfsr<LfsrDefault17>(bench, "LfsrDefault17");
+	bench_lfsr<LfsrDefault18>(bench, "LfsrDefault18");
+	bench_lfsr<LfsrDefault24>(bench, "LfsrDefault24");
+	bench_lfsr<LfsrDefault32>(bench, "LfsrDefault32");
+	bench_lfsr<LfsrDefault64>(bench, "LfsrDefault64");
+#ifdef __SIZEOF_INT128__
+	bench_lfsr<LfsrDefault128>(bench, "LfsrDefault128");
+#endif
+	return 0;
+}
@@ -0,0 +1,52 @@
+#include "embedded_drivers/nrfx/lfsr_rng.h"
+#include "nrfx_rng.h"
+#include "bench.h"
+
+#include <atomic>
+#include <thread>
+
+// Measures the cost of the RNG interrupt handler of nrfx/lfsr_rng and the
+// throughput of taking random bytes from the pool, on the host.
+
+static const unsigned cBatch = 16;
+
+int main(int argc, char ** argv)
+{
+	Bench bench(argc, argv);
+
+	lfsr_rng_init();
+
+	// interrupt handler cost, with the pool drained between bursts
+	uint8_t value = 0;
+	bench.Run("lfsr_rng", "irq+reseed", cBatch, 8 * cBatch, [&]() {
+			for (unsigned i = 0; i < cBatch; ++i)
+				nrfx_rng_stub_irq(value++);
+			lfsr_rng.Reseed();
+		});
+	bench.Run("lfsr_rng", "irq", 1, 8, [&]() {
+			nrfx_rng_stub_irq(value++);
+			if (lfsr_rng.Pending() == 32)
+				lfsr_rng.Reseed();
+		});
+
+	for (unsigned count : { 8, 16 }) {
+		bench.Run("lfsr_rng", "Iterate", count, count, [&]() {
+				bench_keep(lfsr_rng.Iterate(count));
+			});
+	}
+
+	// with a concurrent producer, which also takes the batched reseeding
+	std::atomic<bool> done(false);
+	std::thread producer([&]() {
+		for (uint8_t b = 0; !done; ++b)
+			nrfx_rng_stub_irq(b);
+	});
+	bench.Run("lfsr_rng", "Iterate busy", 8, 8, [&]() {
+			bench_keep(lfsr_rng.Iterate(8));
+		});
+	done = true;
+	producer.join();
+
+	lfsr_rng_deinit();
+	return 0;
+}
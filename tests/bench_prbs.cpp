@@ -0,0 +1,51 @@
+#include "embedded_drivers/prbs.h"
+#include "bench.h"
+
+#include <vector>
+
+using namespace embedded_drivers;
+
+// Measures PRBS generation and checking throughput, against a checker
+// that compares bit by bit.
+
+static const size_t cBufferSize = 1 << 16;
+
+template <class LFSR>
+void bench_prbs(Bench & bench, char const * name)
+{
+	std::vector<uint8_t> buffer(cBufferSize);
+	PrbsGenerator<LFSR> generator;
+	PrbsChecker<LFSR> checker;
+
+	bench.Run(name, "generate", cBufferSize, 8 * cBufferSize, [&]() {
+			generator.Fill(buffer.data(), buffer.size());
+			bench_keep(buffer[0]);
+		});
+
+	// buffers follow each other seamlessly only if the period divides
+	// the buffer bits, so re-lock for each call
+	bench.Run(name, "check", cBufferSize, 8 * cBufferSize, [&]() {
+			checker.Reset();
+			bench_keep(checker.Check(buffer.data(), buffer.size()));
+		});
+
+	LFSR lfsr;
+	bench.Run(name, "bitwise check", cBufferSize, 8 * cBufferSize, [&]() {
+			unsigned errors = 0;
+			for (size_t i = 0; i < buffer.size(); ++i)
+				for (int b = 7; b >= 0; --b)
+					errors += ((buffer[i] >> b) & 1) ^ lfsr.Iterate(1);
+			bench_keep(errors);
+		});
+}
+
+int main(int argc, char ** argv)
+{
+	Bench bench(argc, argv);
+
+	bench_prbs<LfsrPrbs7>(bench, "PRBS7");
+	bench_prbs<LfsrPrbs15>(bench, "PRBS15");
+	bench_prbs<LfsrPrbs23>(bench, "PRBS23");
+	bench_prbs<LfsrPrbs31>(bench, "PRBS31");
+	return 0;
+}
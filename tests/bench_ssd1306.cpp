@@ -0,0 +1,190 @@
+#include "embedded_drivers/ssd1306_i2c_display.h"
+#include "embedded_drivers/font_tama_mini02.h"
+#include "embedded_drivers/ssd1306_animation.h"
+#include "embedded_drivers/ssd1306_gray_surface.h"
+#include "embedded_drivers/tools/ssd1306_animation_encoder.h"
+#include "bench.h"
+
+#include <cmath>
+#include "ssd1306_emulator.h"
+
+using namespace embedded_drivers;
+
+// Measures the CPU time the display driver spends per call, with the
+// emulated panel decoding its traffic. The bits of a call are the bits it
+// puts on the bus, so MB/s is the I2C data rate the driver could sustain.
+// The bus time of a call at 400 KHz is printed below.
+
+struct Panel {
+	Ssd1306Emulator emulator;
+	uint8_t framebuffer[Ssd1306I2cDisplay::cFramebufferSize];
+	Ssd1306I2cDisplay display;
+
+	Panel(bool buffered)
+		: display(&emulator, Ssd1306Emulator::Sleep, &emulator, Ssd1306Emulator::Tx, Ssd1306Emulator::Rx,
+				font_tama_mini02::dataptr, false, buffered ? framebuffer : NULL)
+	{
+	}
+};
+
+template <class F>
+void bench_display(Bench & bench, char const * name, char const * variant, Panel & panel, F call)
+{
+	// the traffic of a call after the first, then time it
+	call();
+	panel.emulator.ResetCounters();
+	call();
+	Ssd1306Emulator traffic = panel.emulator;
+
+	bench.Run(name, variant, traffic.mTransactions, 8 * traffic.mBytes, call);
+	printf("%-24s %-16s %8zu bytes in %zu transactions, %.2f ms on the bus\n", "", "",
+			traffic.mBytes, traffic.mTransactions, 1e3 * traffic.BusSeconds());
+}
+
+static void bench_ssd1306(Bench & bench, bool buffered)
+{
+	char const * variant = buffered ? "shadow" : "direct";
+	Panel panel(buffered);
+
+	static char const line[] = "temperature 21.5C\r\n";
+	bench_display(bench, "Write line", variant, panel, [&]() {
+			panel.display.Write(line, sizeof(line) - 1);
+			panel.display.Flush();
+		});
+
+	static char const screen[] =
+		"Status screen\r\nsensor 0:     0\r\nsensor 1:   100\r\nsensor 2:   200\r\n"
+		"sensor 3:   300\r\nsensor 4:   400\r\nsensor 5:   500\r\nall systems nominal";
+	unsigned value = 0;
+	bench_display(bench, "Write screen", variant, panel, [&]() {
+			char buf[sizeof(screen)];
+			memcpy(buf, screen, sizeof(screen));
+			buf[sizeof("Status screen\r\nsensor 0:    ") - 1] = '0' + (++value % 10);
+			panel.display.CursorSetPosition(0, 0);
+			panel.display.Write(buf, sizeof(buf) - 1);
+			panel.display.Flush();
+		});
+
+	bench_display(bench, "Clear", variant, panel, [&]() {
+			panel.display.Puts("x");
+			panel.display.Clear();
+			panel.display.Flush();
+		});
+
+	bench_display(bench, "Test", variant, panel, [&]() {
+			panel.display.Test();
+			panel.display.Flush();
+		});
+}
+
+// A ball bouncing over a scrolling floor, 64 frames.
+static std::vector<uint8_t> animation_stream(size_t & raw)
+{
+	Ssd1306AnimationEncoder encoder(128, 8, 20);
+	raw = 0;
+	for(unsigned i = 0; i < 64; ++i) {
+		Ssd1306AnimationEncoder::Frame frame(128 * 8, 0);
+		for(unsigned x = 0; x < 128; ++x)
+			frame[7 * 128 + x] = ((x + i) % 16 < 8) ? 0xe0 : 0x00;
+		int cx = 10 + (i * 5) % 108;
+		int cy = 10 + abs(int(i % 32) - 16) * 2;
+		for(int y = cy - 8; y <= cy + 8; ++y)
+			for(int x = cx - 8; x <= cx + 8; ++x)
+				if((x - cx) * (x - cx) + (y - cy) * (y - cy) <= 64)
+					frame[(y / 8) * 128 + x] |= 1 << (y % 8);
+		encoder.Add(frame);
+		raw += frame.size();
+	}
+	return encoder.Stream();
+}
+
+static void fill_raw(void * context, uint8_t * buffer, unsigned len)
+{
+	uint8_t const ** frame = static_cast<uint8_t const **>(context);
+	memcpy(buffer, *frame, len);
+	*frame += len;
+}
+
+static void bench_animation(Bench & bench, bool buffered)
+{
+	char const * variant = buffered ? "shadow" : "direct";
+	Panel panel(buffered);
+
+	size_t raw;
+	std::vector<uint8_t> stream = animation_stream(raw);
+	Ssd1306Animation animation(stream.data(), stream.size());
+	printf("%-24s %-16s %8zu bytes of frames in a %zu bytes stream\n", "", "", raw, stream.size());
+
+	// one frame per call, looping: averaged over all frames
+	size_t bytes = 0;
+	auto frame = [&]() {
+			if(!animation.DrawFrame(panel.display)) {
+				panel.display.Clear();
+				animation.Rewind();
+				animation.DrawFrame(panel.display);
+			}
+			panel.display.Flush();
+		};
+	panel.emulator.ResetCounters();
+	for(unsigned i = 0; i < animation.FrameCount(); ++i)
+		frame();
+	bytes = panel.emulator.mBytes / animation.FrameCount();
+	double bus = panel.emulator.BusSeconds() / animation.FrameCount();
+	bench.Run("Animation frame", variant, animation.FrameCount(), 8 * bytes, frame);
+	printf("%-24s %-16s %8zu bytes per frame, %.0f frames/s on the bus\n", "", "", bytes, 1 / bus);
+
+	// a frame pushed in full, which the shadow would only send once
+	if(buffered)
+		return;
+	std::vector<uint8_t> full(128 * 8, 0x55);
+	auto push = [&]() {
+			uint8_t const * p = full.data();
+			for(unsigned page = 0; page < 8; ++page)
+				panel.display.DrawSpan(page, 0, 128, fill_raw, &p);
+		};
+	panel.emulator.ResetCounters();
+	push();
+	bytes = panel.emulator.mBytes;
+	bus = panel.emulator.BusSeconds();
+	bench.Run("Raw frame", variant, 1, 8 * bytes, push);
+	printf("%-24s %-16s %8zu bytes per frame, %.0f frames/s on the bus\n", "", "", bytes, 1 / bus);
+}
+
+// Sub-frames of a trend plot in four gray levels: the CPU time of one
+// must stay well below its bus time, to keep the bus busy.
+static void bench_gray(Bench & bench)
+{
+	Panel panel(true);
+	Ssd1306GraySurface<Ssd1306I2cDisplay> gray(panel.display);
+	gray.FillRect(0, 0, 128, 16, 1);
+	for(int x = 0; x < 128; x += 8)
+		gray.FillRect(x, 16, 1, 48, 1);
+	for(int x = 0; x < 127; ++x)
+		gray.DrawLine(x, 40 + 20 * sin(x / 10.0), x + 1, 40 + 20 * sin((x + 1) / 10.0), 3);
+	gray.FillRect(0, 58, 128, 6, 2);
+
+	auto frame = [&]() {
+			gray.Refresh();
+			panel.display.Flush();
+		};
+	frame();
+	panel.emulator.ResetCounters();
+	for(unsigned i = 0; i < 100; ++i)
+		frame();
+	size_t bytes = panel.emulator.mBytes / 100;
+	double bus = panel.emulator.BusSeconds() / 100;
+	bench.Run("Gray sub-frame", "shadow", 1, 8 * bytes, frame);
+	printf("%-24s %-16s %8zu bytes per sub-frame, %.0f sub-frames/s on the bus\n", "", "", bytes, 1 / bus);
+}
+
+int main(int argc, char ** argv)
+{
+	Bench bench(argc, argv);
+
+	bench_ssd1306(bench, false);
+	bench_ssd1306(bench, true);
+	bench_animation(bench, false);
+	bench_animation(bench, true);
+	bench_gray(bench);
+	return 0;
+}
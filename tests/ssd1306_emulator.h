@@ -0,0 +1,339 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// Host model of an SSD1306 controller behind the i2cTx callback of
+// Ssd1306I2cDisplay: decodes the command and data stream into the 128x8
+// page display RAM, keeps the display state the driver changes and counts
+// the bus traffic. Snapshots of the screen are written as PBM:
+//
+//   Ssd1306Emulator panel;
+//   Ssd1306I2cDisplay display(NULL, Ssd1306Emulator::Sleep, &panel,
+//		Ssd1306Emulator::Tx, Ssd1306Emulator::Rx, font);
+//   ...
+//   panel.WritePbm("screen.pbm");
+//
+// Anything the controller would not accept is counted in mErrors.
+class Ssd1306Emulator {
+public:
+	static constexpr unsigned cColumns = 128;
+	static constexpr unsigned cPages = 8;
+	static constexpr unsigned cRows = 8 * cPages;
+
+	uint8_t mRam[cPages][cColumns];
+
+	// addressing
+	unsigned mAddressingMode;	// 0 horizontal, 1 vertical, 2 page
+	unsigned mColStart, mColEnd, mPageStart, mPageEnd;
+	unsigned mCol, mPage;
+
+	// display state
+	unsigned mStartLine;
+	unsigned mDisplayOffset;
+	unsigned mMultiplex;
+	unsigned mComPins;
+	unsigned mContrast;
+	bool mDisplayOn;
+	bool mEntireDisplayOn;
+	bool mInverse;
+	bool mSegmentRemap;
+	bool mComReversed;
+
+	// continuous scrolling, applied by ScrollStep()
+	bool mScrollActive;
+	bool mScrollLeft;
+	unsigned mScrollStartPage, mScrollEndPage;
+	unsigned mScrollVerticalOffset;
+
+	// traffic
+	uint8_t mAddress;
+	size_t mBytes;
+	size_t mTransactions;
+	size_t mCommandTransactions;
+	size_t mDataBytes;
+	size_t mBusBits;
+	size_t mSleepMsecs;
+	size_t mErrors;
+
+	Ssd1306Emulator(uint8_t address = 0x3c)
+		: mAddress(address)
+	{
+		// display RAM is random after power on
+		memset(mRam, 0xa5, sizeof(mRam));
+		mAddressingMode = 2;
+		mColStart = mCol = 0;
+		mColEnd = cColumns - 1;
+		mPageStart = mPage = 0;
+		mPageEnd = cPages - 1;
+		mStartLine = 0;
+		mDisplayOffset = 0;
+		mMultiplex = cRows - 1;
+		mComPins = 0x12;
+		mContrast = 0x7f;
+		mDisplayOn = false;
+		mEntireDisplayOn = false;
+		mInverse = false;
+		mSegmentRemap = false;
+		mComReversed = false;
+		mScrollActive = false;
+		mScrollLeft = false;
+		mScrollStartPage = 0;
+		mScrollEndPage = cPages - 1;
+		mScrollVerticalOffset = 0;
+		ResetCounters();
+	}
+
+	void ResetCounters(void)
+	{
+		mBytes = 0;
+		mTransactions = 0;
+		mCommandTransactions = 0;
+		mDataBytes = 0;
+		mBusBits = 0;
+		mSleepMsecs = 0;
+		mErrors = 0;
+	}
+
+	// Time the traffic so far takes on a bus of `hz`.
+	double BusSeconds(unsigned hz = 400000) const
+	{
+		return double(mBusBits) / hz;
+	}
+
+	// Callbacks for Ssd1306I2cDisplay, `context` is the emulator.
+	static bool Tx(void * context, uint8_t address, uint8_t const * buffer, size_t len)
+	{
+		Ssd1306Emulator * panel = static_cast<Ssd1306Emulator *>(context);
+		if(address != panel->mAddress) {
+			++panel->mErrors;
+			return false;
+		}
+		panel->Transfer(buffer, len);
+		return true;
+	}
+
+	static bool Rx(void *, uint8_t, uint8_t *, size_t)
+	{
+		return false;
+	}
+
+	static void Sleep(void * context, unsigned msecs)
+	{
+		if(context)
+			static_cast<Ssd1306Emulator *>(context)->mSleepMsecs += msecs;
+	}
+
+	// Decodes one I2C write transaction, without the address byte.
+	void Transfer(uint8_t const * buf, size_t len)
+	{
+		if(len < 2)
+			++mErrors;
+		mBytes += len;
+		++mTransactions;
+		// start, address and data bytes with their ACKs, stop
+		mBusBits += 1 + 9 * (len + 1) + 1;
+
+		// Control bytes with Co set are followed by a single byte and the
+		// next control byte, without Co by a stream until the end.
+		bool data = false;
+		size_t i = 0;
+		while(i < len) {
+			uint8_t control = buf[i++];
+			if(control & 0x3f)
+				++mErrors;
+			bool stream = !(control & 0x80);
+			data = (control & 0x40);
+			size_t end = stream ? len : std::min(i + 1, len);
+			for(; i < end; ++i) {
+				if(data)
+					DataByte(buf[i]);
+				else
+					CommandByte(buf[i]);
+			}
+		}
+		if(!data)
+			++mCommandTransactions;
+		// the driver never splits a command across transfers
+		if(mPendingCount) {
+			++mErrors;
+			mPendingCount = 0;
+		}
+	}
+
+	// Moves the scrolled pages by one column, as the controller does once
+	// per scroll interval while scrolling is active.
+	void ScrollStep(void)
+	{
+		if(!mScrollActive)
+			return;
+		for(unsigned page = mScrollStartPage; page <= mScrollEndPage && page < cPages; ++page) {
+			if(mScrollLeft)
+				std::rotate(&mRam[page][0], &mRam[page][1], &mRam[page][cColumns]);
+			else
+				std::rotate(&mRam[page][0], &mRam[page][cColumns-1], &mRam[page][cColumns]);
+		}
+		mStartLine = (mStartLine + mScrollVerticalOffset) % cRows;
+	}
+
+	bool RamPixel(unsigned col, unsigned row) const
+	{
+		return (mRam[(row / 8) % cPages][col] >> (row % 8)) & 1;
+	}
+
+	// Pixel at `x`, `y` of the screen, as the viewer sees it.
+	bool Pixel(unsigned x, unsigned y) const
+	{
+		if(!mDisplayOn)
+			return false;
+		if(mEntireDisplayOn)
+			return true;
+		unsigned com = mComReversed ? (mMultiplex - y) : y;
+		unsigned seg = mSegmentRemap ? (cColumns - 1 - x) : x;
+		unsigned row = (com + mStartLine + mDisplayOffset) % cRows;
+		return RamPixel(seg, row) != mInverse;
+	}
+
+	// Writes the screen as binary PBM. Panels narrower than the RAM show
+	// `width` columns from `columnOffset` on, and mMultiplex+1 rows.
+	bool WritePbm(char const * path, unsigned width = cColumns, unsigned columnOffset = 0) const
+	{
+		FILE * file = fopen(path, "wb");
+		if(!file)
+			return false;
+		unsigned height = mMultiplex + 1;
+		fprintf(file, "P4\n%u %u\n", width, height);
+		for(unsigned y = 0; y < height; ++y) {
+			uint8_t byte = 0;
+			for(unsigned x = 0; x < width; ++x) {
+				byte = (byte << 1) | Pixel(columnOffset + x, y);
+				if(x % 8 == 7 || x + 1 == width) {
+					byte <<= 7 - (x % 8);
+					fputc(byte, file);
+					byte = 0;
+				}
+			}
+		}
+		return !fclose(file);
+	}
+
+	bool SameImage(Ssd1306Emulator const & other) const
+	{
+		return !memcmp(mRam, other.mRam, sizeof(mRam)) && mStartLine == other.mStartLine;
+	}
+
+	// Compares what is visible, pages counted from the start line.
+	bool SameScreen(Ssd1306Emulator const & other, unsigned pages = cPages) const
+	{
+		for(unsigned page = 0; page < pages; ++page)
+			if(memcmp(mRam[(mStartLine/8 + page) % cPages], other.mRam[(other.mStartLine/8 + page) % cPages], cColumns))
+				return false;
+		return true;
+	}
+
+private:
+	uint8_t mPending[7];
+	unsigned mPendingCount = 0;
+
+	static unsigned ArgumentCount(uint8_t command)
+	{
+		switch(command) {
+			case 0x20: case 0x81: case 0x8d: case 0xa8:
+			case 0xd3: case 0xd5: case 0xd9: case 0xda: case 0xdb:
+				return 1;
+			case 0x21: case 0x22: case 0xa3:
+				return 2;
+			case 0x29: case 0x2a:
+				return 5;
+			case 0x26: case 0x27:
+				return 6;
+			default:
+				return 0;
+		}
+	}
+
+	// Collects command bytes until a command and its arguments are complete.
+	void CommandByte(uint8_t byte)
+	{
+		mPending[mPendingCount++] = byte;
+		if(mPendingCount <= ArgumentCount(mPending[0]))
+			return;
+		mPendingCount = 0;
+
+		uint8_t command = mPending[0];
+		if(command <= 0x0f) {
+			mCol = (mCol & 0xf0) | command;
+		} else if(command <= 0x1f) {
+			mCol = ((command & 0x0f) << 4) | (mCol & 0x0f);
+		} else if(command == 0x20) {
+			mAddressingMode = mPending[1] & 3;
+		} else if(command == 0x21) {
+			mCol = mColStart = mPending[1] % cColumns;
+			mColEnd = mPending[2] % cColumns;
+		} else if(command == 0x22) {
+			mPage = mPageStart = mPending[1] % cPages;
+			mPageEnd = mPending[2] % cPages;
+		} else if(command == 0x26 || command == 0x27) {
+			mScrollLeft = (command == 0x27);
+			mScrollStartPage = mPending[2] % cPages;
+			mScrollEndPage = mPending[4] % cPages;
+			mScrollVerticalOffset = 0;
+		} else if(command == 0x29 || command == 0x2a) {
+			mScrollLeft = (command == 0x2a);
+			mScrollStartPage = mPending[2] % cPages;
+			mScrollEndPage = mPending[4] % cPages;
+			mScrollVerticalOffset = mPending[5] % cRows;
+		} else if(command == 0x2e) {
+			mScrollActive = false;
+		} else if(command == 0x2f) {
+			mScrollActive = true;
+		} else if(command >= 0x40 && command <= 0x7f) {
+			mStartLine = command - 0x40;
+		} else if(command == 0x81) {
+			mContrast = mPending[1];
+		} else if(command == 0xa0 || command == 0xa1) {
+			mSegmentRemap = (command == 0xa1);
+		} else if(command == 0xa4 || command == 0xa5) {
+			mEntireDisplayOn = (command == 0xa5);
+		} else if(command == 0xa6 || command == 0xa7) {
+			mInverse = (command == 0xa7);
+		} else if(command == 0xa8) {
+			mMultiplex = std::max<unsigned>(mPending[1] % cRows, 15);
+		} else if(command == 0xae || command == 0xaf) {
+			mDisplayOn = (command == 0xaf);
+		} else if(command >= 0xb0 && command <= 0xb7) {
+			mPage = command - 0xb0;
+		} else if(command == 0xc0 || command == 0xc8) {
+			mComReversed = (command == 0xc8);
+		} else if(command == 0xd3) {
+			mDisplayOffset = mPending[1] % cRows;
+		} else if(command == 0xda) {
+			mComPins = mPending[1];
+		}
+	}
+
+	void DataByte(uint8_t byte)
+	{
+		mRam[mPage][mCol] = byte;
+		++mDataBytes;
+		if(mAddressingMode == 1) {
+			if(++mPage > mPageEnd) {
+				mPage = mPageStart;
+				if(++mCol > mColEnd)
+					mCol = mColStart;
+			}
+		} else if(mAddressingMode == 0) {
+			if(++mCol > mColEnd) {
+				mCol = mColStart;
+				if(++mPage > mPageEnd)
+					mPage = mPageStart;
+			}
+		} else {
+			// page addressing stays in the page
+			mCol = (mCol + 1) % cColumns;
+		}
+	}
+};
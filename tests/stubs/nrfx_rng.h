@@ -0,0 +1,75 @@
+/*
+    This file is part of embedded_drivers.
+
+    embedded_drivers is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    embedded_drivers is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with embedded_drivers.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// Host stub of the nrfx RNG driver, to build nrfx/lfsr_rng.cpp on Linux.
+// nrfx_rng_stub_irq() stands in for the RNG interrupt.
+
+#include <cstdint>
+
+typedef uint32_t nrfx_err_t;
+#define NRFX_SUCCESS 0
+
+#define NRFX_RNG_CONFIG_ERROR_CORRECTION 1
+#define NRFX_RNG_CONFIG_IRQ_PRIORITY 6
+
+typedef struct {
+	bool error_correction;
+	uint8_t interrupt_priority;
+} nrfx_rng_config_t;
+
+typedef void (* nrfx_rng_evt_handler_t)(uint8_t rng_data);
+
+struct nrfx_rng_stub_state {
+	nrfx_rng_evt_handler_t handler;
+	bool started;
+	nrfx_rng_config_t config;
+};
+
+inline nrfx_rng_stub_state nrfx_rng_stub = { nullptr, false, { false, 0 } };
+
+inline nrfx_err_t nrfx_rng_init(nrfx_rng_config_t const * p_config, nrfx_rng_evt_handler_t handler)
+{
+	nrfx_rng_stub.config = *p_config;
+	nrfx_rng_stub.handler = handler;
+	return NRFX_SUCCESS;
+}
+
+inline void nrfx_rng_start(void)
+{
+	nrfx_rng_stub.started = true;
+}
+
+inline void nrfx_rng_stop(void)
+{
+	nrfx_rng_stub.started = false;
+}
+
+inline void nrfx_rng_uninit(void)
+{
+	nrfx_rng_stub.handler = nullptr;
+}
+
+// Delivers one byte from the "hardware", as the RNG interrupt would.
+inline bool nrfx_rng_stub_irq(uint8_t rng_data)
+{
+	if (!nrfx_rng_stub.started || !nrfx_rng_stub.handler)
+		return false;
+	nrfx_rng_stub.handler(rng_data);
+	return true;
+}
@@ -0,0 +1,136 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Main
+#include <boost/test/included/unit_test.hpp>
+
+#include "embedded_drivers/crc.h"
+#include "embedded_drivers/si7020_i2c_sensor.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace embedded_drivers;
+
+
+static uint8_t const check_string[] = "123456789";
+
+template <class CRC>
+static typename CRC::BaseType check_value(void)
+{
+	return CRC::Compute(check_string, 9);
+}
+
+template <class CRC>
+static void check_table_matches_bitwise(void)
+{
+	std::vector<uint8_t> data(301);
+	LfsrDefault32 lfsr;
+	lfsr.Fill(data.data(), data.size());
+
+	for (size_t offset : { 0, 1, 3, 7 })
+		for (size_t len = 0; len + offset <= data.size(); len += 13) {
+			CRC table;
+			CRC bitwise;
+			table.Update(data.data() + offset, len);
+			bitwise.UpdateBitwise(data.data() + offset, len);
+			BOOST_REQUIRE(table.Get() == bitwise.Get());
+		}
+}
+
+template <class T, unsigned int WIDTH, T POLY, T INIT, bool REFLECTED, T XOROUT>
+static void check_slices(T expected)
+{
+	BOOST_REQUIRE((check_value<Crc<T, WIDTH, POLY, INIT, REFLECTED, XOROUT, 1>>() == expected));
+	BOOST_REQUIRE((check_value<Crc<T, WIDTH, POLY, INIT, REFLECTED, XOROUT, 4>>() == expected));
+	BOOST_REQUIRE((check_value<Crc<T, WIDTH, POLY, INIT, REFLECTED, XOROUT, 8>>() == expected));
+	check_table_matches_bitwise<Crc<T, WIDTH, POLY, INIT, REFLECTED, XOROUT, 1>>();
+	check_table_matches_bitwise<Crc<T, WIDTH, POLY, INIT, REFLECTED, XOROUT, 4>>();
+	check_table_matches_bitwise<Crc<T, WIDTH, POLY, INIT, REFLECTED, XOROUT, 8>>();
+}
+
+BOOST_AUTO_TEST_CASE(crc_check_values)
+{
+	BOOST_REQUIRE(check_value<Crc8Si7020>() == 0xa2);
+	BOOST_REQUIRE(check_value<Crc16CcittFalse>() == 0x29b1);
+	BOOST_REQUIRE(check_value<Crc16Modbus>() == 0x4b37);
+	BOOST_REQUIRE(check_value<Crc32>() == 0xcbf43926);
+
+	check_slices<uint8_t, 8, 0x31, 0x00, false, 0x00>(0xa2);
+	check_slices<uint8_t, 8, 0x07, 0x00, false, 0x00>(0xf4);		// CRC-8/SMBUS
+	check_slices<uint8_t, 5, 0x05, 0x1f, true, 0x1f>(0x19);		// CRC-5/USB
+	check_slices<uint16_t, 16, 0x1021, 0xffff, false, 0x0000>(0x29b1);
+	check_slices<uint16_t, 16, 0x8005, 0xffff, true, 0x0000>(0x4b37);
+	check_slices<uint32_t, 24, 0x864cfb, 0xb704ce, false, 0x000000>(0x21cf02);	// CRC-24/OPENPGP
+	check_slices<uint32_t, 32, 0x04c11db7, 0xffffffff, true, 0xffffffff>(0xcbf43926);
+	check_slices<uint32_t, 32, 0x04c11db7, 0xffffffff, false, 0xffffffff>(0xfc891918);	// CRC-32/BZIP2
+	check_slices<uint64_t, 64, 0x42f0e1eba9ea3693, 0xffffffffffffffff, true, 0xffffffffffffffff>(0x995dc9bbdf1939fa);	// CRC-64/XZ
+}
+
+BOOST_AUTO_TEST_CASE(crc_incremental)
+{
+	Crc32 crc;
+	crc.Update(check_string, 2);
+	crc.Update(check_string + 2, 7);
+	BOOST_REQUIRE(crc.Get() == 0xcbf43926);
+	crc.Reset();
+	crc.Update(check_string, 9);
+	BOOST_REQUIRE(crc.Get() == 0xcbf43926);
+}
+
+BOOST_AUTO_TEST_CASE(crc_shares_lfsr_step_table)
+{
+	LfsrStepTable<uint32_t, 0xedb88320, 8> steps;
+	CrcSliceTable<uint32_t, 32, 0x04c11db7, true, 1> table;
+	for (unsigned v = 0; v < 256; ++v)
+		BOOST_REQUIRE(steps.mFeedback[v] == table.mTable[0][v]);
+}
+
+// Fake Si7020 on the I2C bus, answering with fixed codes.
+struct FakeSi7020 {
+	uint8_t command;
+	uint16_t rh_code;
+	uint16_t temp_code;
+	bool corrupt;
+};
+
+static bool fake_tx(void * context, uint8_t address, const uint8_t * buffer, size_t len)
+{
+	FakeSi7020 * fake = (FakeSi7020 *)context;
+	BOOST_REQUIRE(address == 0x40);
+	BOOST_REQUIRE(len == 1);
+	fake->command = buffer[0];
+	return true;
+}
+
+static bool fake_rx(void * context, uint8_t address, uint8_t * buffer, size_t len)
+{
+	FakeSi7020 * fake = (FakeSi7020 *)context;
+	uint16_t code = (fake->command == 0xe5) ? fake->rh_code : fake->temp_code;
+	uint8_t response[3] = { uint8_t(code >> 8), uint8_t(code), 0 };
+	response[2] = Crc8Si7020::Compute(response, 2) ^ (fake->corrupt ? 1 : 0);
+
+	BOOST_REQUIRE(address == 0x40);
+	BOOST_REQUIRE(len == ((fake->command == 0xe0) ? 2u : 3u));
+	memcpy(buffer, response, len);
+	return true;
+}
+
+BOOST_AUTO_TEST_CASE(si7020_checksum)
+{
+	// 0x7c80 is 54.79 %RH, 0x6420 is 21.88 °C
+	FakeSi7020 fake = { 0, 0x7c80, 0x6420, false };
+	Si7020I2cSensor sensor(&fake, fake_tx, fake_rx);
+
+	BOOST_REQUIRE(std::fabs(sensor.ReadHumidity() - 54.79) < 0.01);
+	BOOST_REQUIRE(std::fabs(sensor.ReadTemperature() - 21.88) < 0.01);
+	std::pair<float, float> both = sensor.ReadHumidityTemperature();
+	BOOST_REQUIRE(std::fabs(both.first - 54.79) < 0.01);
+	BOOST_REQUIRE(std::fabs(both.second - 21.88) < 0.01);
+
+	fake.corrupt = true;
+	BOOST_REQUIRE(sensor.ReadHumidity() == -1.f);
+	BOOST_REQUIRE(sensor.ReadTemperature() == -999.f);
+	both = sensor.ReadHumidityTemperature();
+	BOOST_REQUIRE(both.first == -1.f);
+	BOOST_REQUIRE(both.second == -999.f);
+}
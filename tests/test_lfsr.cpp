@@ -5,19 +5,37 @@
 
 #include "../lfsr.h"
 #include <cstdio>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
 
 
+// Widths above this are only checked via the primitivity test, not by
+// walking the whole period.
+static const unsigned cMaxPeriodWalkWidth = 18;
+
 template <class T>
 void test_lfsr()
 {
-	const unsigned long long expected_period = (1ULL << T::cWidth) - 1;
+	bool maximal = T::IsMaximal();
+	printf("%u bits: feedback 0x%llx is %s\n", T::cWidth,
+			static_cast<unsigned long long>(T::cFeedback),
+			maximal ? "primitive" : "NOT primitive");
+	BOOST_REQUIRE(maximal);
+	if (T::cWidth > cMaxPeriodWalkWidth) {
+		printf("\n");
+		return;
+	}
+
+	const unsigned long long expected_period = static_cast<unsigned long long>(T::cMaximalPeriod);
 	T lfsr;
 	typename T::BaseType first = lfsr.GetRegisterState();
 	typename T::BaseType next;
 	typename T::BaseType out;
 	unsigned long long period;
 
-	printf("%u bits:\n", T::cWidth);
 	printf("  [ 0x%llx", static_cast<unsigned long long>(first));
 	for (period = 1; period <= expected_period; ++period) {
 		out = lfsr.Iterate();
@@ -43,6 +61,11 @@ void test_lfsr()
 
 
 
+#ifdef __SIZEOF_INT128__
+static_assert(embedded_drivers::LfsrDefault128::IsMaximal(),
+		"LfsrDefault128 does not have maximal period.");
+#endif
+
 BOOST_AUTO_TEST_CASE(lfsr)
 {
 	test_lfsr<embedded_drivers::LfsrDefault4>();
@@ -56,4 +79,341 @@ BOOST_AUTO_TEST_CASE(lfsr)
 	test_lfsr<embedded_drivers::LfsrDefault18>();
 	test_lfsr<embedded_drivers::LfsrDefault24>();
 	test_lfsr<embedded_drivers::LfsrDefault32>();
+	test_lfsr<embedded_drivers::LfsrDefault64>();
+#ifdef __SIZEOF_INT128__
+	test_lfsr<embedded_drivers::LfsrDefault128>();
+#endif
+}
+
+template <class T, unsigned STEP_BITS>
+void test_lfsr_table()
+{
+	const unsigned max_count = 8 * sizeof(typename T::BaseType);
+	std::mt19937 rng(T::cWidth);
+	T reference;
+	T table;
+
+	for (unsigned i = 0; i < 20000; ++i) {
+		unsigned count = rng() % (max_count + 1);
+		typename T::BaseType input = 0;
+		if (0 == (i % 7))
+			input = static_cast<typename T::BaseType>(rng()) & static_cast<typename T::BaseType>(T::cMaximalPeriod);
+
+		typename T::BaseType expected = reference.Iterate(count, input);
+		typename T::BaseType out = table.template IterateTable<STEP_BITS>(count, input);
+
+		BOOST_REQUIRE(expected == out);
+		BOOST_REQUIRE(reference.GetRegisterState() == table.GetRegisterState());
+	}
+}
+
+template <class T>
+void test_lfsr_tables()
+{
+	printf("%u bits: table stepping\n", T::cWidth);
+	test_lfsr_table<T, 1>();
+	test_lfsr_table<T, 8>();
+	// 16 bit tables of wide registers take long to compile
+	if constexpr (sizeof(typename T::BaseType) <= sizeof(uint32_t))
+		test_lfsr_table<T, 16>();
+}
+
+BOOST_AUTO_TEST_CASE(lfsr_table)
+{
+	test_lfsr_tables<embedded_drivers::LfsrDefault4>();
+	test_lfsr_tables<embedded_drivers::LfsrDefault8>();
+	test_lfsr_tables<embedded_drivers::LfsrDefault9>();
+	test_lfsr_tables<embedded_drivers::LfsrDefault10>();
+	test_lfsr_tables<embedded_drivers::LfsrDefault15>();
+	test_lfsr_tables<embedded_drivers::LfsrFibonacci>();
+	test_lfsr_tables<embedded_drivers::LfsrDefault16>();
+	test_lfsr_tables<embedded_drivers::LfsrDefault17>();
+	test_lfsr_tables<embedded_drivers::LfsrDefault18>();
+	test_lfsr_tables<embedded_drivers::LfsrDefault24>();
+	test_lfsr_tables<embedded_drivers::LfsrDefault32>();
+	test_lfsr_tables<embedded_drivers::LfsrDefault64>();
+#ifdef __SIZEOF_INT128__
+	test_lfsr_tables<embedded_drivers::LfsrDefault128>();
+#endif
+}
+
+template <class T>
+void test_lfsr_skip()
+{
+	printf("%u bits: skip\n", T::cWidth);
+	std::mt19937 rng(T::cWidth);
+
+	for (unsigned i = 0; i < 200; ++i) {
+		unsigned steps = rng() % 5000;
+		T reference;
+		T skipped;
+		reference.Iterate(1, 1 + (i % 3));
+		skipped.Iterate(1, 1 + (i % 3));
+		for (unsigned k = 0; k < steps; ++k)
+			reference.Iterate();
+		skipped.Skip(steps);
+		BOOST_REQUIRE(reference.GetRegisterState() == skipped.GetRegisterState());
+	}
+
+	// a full period must return to the initial state
+	T lfsr;
+	lfsr.Skip(T::cMaximalPeriod);
+	BOOST_REQUIRE(lfsr.GetRegisterState() == T().GetRegisterState());
+	lfsr.Skip(T::cMaximalPeriod - 1);
+	BOOST_REQUIRE(lfsr.GetRegisterState() != T().GetRegisterState());
+	lfsr.Skip(1);
+	BOOST_REQUIRE(lfsr.GetRegisterState() == T().GetRegisterState());
+
+	// substreams are consecutive slices of the period
+	const unsigned substreams = 5;
+	T jumping;
+	for (unsigned k = 0; k < substreams; ++k) {
+		T sub = T::Substream(k, substreams);
+		BOOST_REQUIRE(sub.GetRegisterState() == jumping.GetRegisterState());
+		jumping.Jump(substreams);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(lfsr_skip)
+{
+	test_lfsr_skip<embedded_drivers::LfsrDefault4>();
+	test_lfsr_skip<embedded_drivers::LfsrDefault8>();
+	test_lfsr_skip<embedded_drivers::LfsrDefault9>();
+	test_lfsr_skip<embedded_drivers::LfsrDefault10>();
+	test_lfsr_skip<embedded_drivers::LfsrDefault15>();
+	test_lfsr_skip<embedded_drivers::LfsrFibonacci>();
+	test_lfsr_skip<embedded_drivers::LfsrDefault16>();
+	test_lfsr_skip<embedded_drivers::LfsrDefault17>();
+	test_lfsr_skip<embedded_drivers::LfsrDefault18>();
+	test_lfsr_skip<embedded_drivers::LfsrDefault24>();
+	test_lfsr_skip<embedded_drivers::LfsrDefault32>();
+	test_lfsr_skip<embedded_drivers::LfsrDefault64>();
+#ifdef __SIZEOF_INT128__
+	test_lfsr_skip<embedded_drivers::LfsrDefault128>();
+#endif
+}
+
+template <class T>
+void test_lfsr_bitsliced()
+{
+	printf("%u bits: bit-sliced lanes\n", T::cWidth);
+	const unsigned lanes = embedded_drivers::LfsrBitSliced<T>::cLanes;
+	const unsigned steps = 300;
+	embedded_drivers::LfsrBitSliced<T> sliced;
+	uint64_t words[steps + 1];
+
+	for (unsigned i = 0; i <= steps; ++i)
+		words[i] = sliced.Iterate();
+
+	for (unsigned lane = 0; lane < lanes; ++lane) {
+		T scalar = T::Substream(lane, lanes);
+		for (unsigned i = 0; i < steps; ++i)
+			BOOST_REQUIRE(((words[i] >> lane) & 1) == scalar.Iterate());
+	}
+
+	// Fill() emits the same steps as little-endian words
+	embedded_drivers::LfsrBitSliced<T> filling;
+	uint8_t buffer[8 * steps + 3];
+	filling.Fill(buffer, sizeof(buffer));
+	for (unsigned i = 0; i < sizeof(buffer); ++i)
+		BOOST_REQUIRE(buffer[i] == uint8_t(words[i / 8] >> (8 * (i % 8))));
+
+	// scalar Fill() matches Iterate(8)
+	T reference;
+	T scalar;
+	scalar.Fill(buffer, sizeof(buffer));
+	for (unsigned i = 0; i < sizeof(buffer); ++i)
+		BOOST_REQUIRE(buffer[i] == reference.Iterate(8));
+}
+
+BOOST_AUTO_TEST_CASE(lfsr_bitsliced)
+{
+	test_lfsr_bitsliced<embedded_drivers::LfsrDefault8>();
+	test_lfsr_bitsliced<embedded_drivers::LfsrDefault9>();
+	test_lfsr_bitsliced<embedded_drivers::LfsrDefault10>();
+	test_lfsr_bitsliced<embedded_drivers::LfsrDefault15>();
+	test_lfsr_bitsliced<embedded_drivers::LfsrFibonacci>();
+	test_lfsr_bitsliced<embedded_drivers::LfsrDefault16>();
+	test_lfsr_bitsliced<embedded_drivers::LfsrDefault17>();
+	test_lfsr_bitsliced<embedded_drivers::LfsrDefault18>();
+	test_lfsr_bitsliced<embedded_drivers::LfsrDefault24>();
+	test_lfsr_bitsliced<embedded_drivers::LfsrDefault32>();
+	test_lfsr_bitsliced<embedded_drivers::LfsrDefault64>();
+#ifdef __SIZEOF_INT128__
+	test_lfsr_bitsliced<embedded_drivers::LfsrDefault128>();
+#endif
+}
+
+// Compares the primitivity test against walking the period
+// for every feedback polynomial of small widths.
+BOOST_AUTO_TEST_CASE(lfsr_primitive_exhaustive)
+{
+	using embedded_drivers::lfsr_polynomial::IsPrimitive;
+
+	for (unsigned width = 2; width <= 12; ++width) {
+		const unsigned long long full_period = (1ULL << width) - 1;
+		unsigned maximal_count = 0;
+
+		for (uint16_t feedback = 1 << (width - 1); feedback < (1 << width); ++feedback) {
+			uint16_t reg = 1;
+			unsigned long long period = 0;
+			do {
+				bool bit = reg & 1;
+				reg >>= 1;
+				if (bit)
+					reg ^= feedback;
+				++period;
+			} while ((reg != 1) && (period <= full_period));
+
+			bool walked_maximal = (period == full_period);
+			BOOST_REQUIRE(walked_maximal == (IsPrimitive<uint16_t, uint64_t>(width, feedback)));
+			if (walked_maximal)
+				++maximal_count;
+		}
+		printf("%u bits: %u maximal feedbacks\n", width, maximal_count);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(lfsr_find_maximal_feedback)
+{
+	using embedded_drivers::lfsr_polynomial::FindMaximalFeedback;
+	using embedded_drivers::lfsr_polynomial::IsPrimitive;
+
+	// the search yields the first entries of Koopman's tables
+	static_assert(FindMaximalFeedback<uint8_t, uint64_t>(4) == 0x9, "");
+	static_assert(FindMaximalFeedback<uint8_t, uint64_t>(8) == 0x8E, "");
+	static_assert(FindMaximalFeedback<uint16_t, uint64_t>(16) == 0x8016, "");
+	static_assert(FindMaximalFeedback<uint32_t, uint64_t>(32) == 0x80000057, "");
+	static_assert(FindMaximalFeedback<uint64_t, uint64_t>(48) == 0x80000000005BULL, "");
+	static_assert(FindMaximalFeedback<uint64_t, uint64_t>(64) == 0x800000000000000DULL, "");
+
+	static_assert(!IsPrimitive<uint32_t, uint64_t>(32, 0x80000056), "");
+	static_assert(FindMaximalFeedback<uint8_t, uint64_t>(2, 0x3) == 0, "");
+
+	for (unsigned width = 2; width <= 64; ++width) {
+		uint64_t feedback = FindMaximalFeedback<uint64_t, uint64_t>(width);
+		printf("%u bits: first maximal feedback 0x%llx\n",
+				width, static_cast<unsigned long long>(feedback));
+		BOOST_REQUIRE(feedback != 0);
+		BOOST_REQUIRE((IsPrimitive<uint64_t, uint64_t>(width, feedback)));
+		uint64_t next = FindMaximalFeedback<uint64_t, uint64_t>(width, feedback);
+		BOOST_REQUIRE((next == 0) || (next > feedback));
+		BOOST_REQUIRE((next == 0) || (IsPrimitive<uint64_t, uint64_t>(width, next)));
+	}
+}
+
+template <class T, class W>
+void test_lfsr_wide()
+{
+	const unsigned base_bits = 8 * sizeof(typename T::BaseType);
+	const unsigned wide_bits = 8 * sizeof(W);
+	std::mt19937 rng(T::cWidth);
+	T reference;
+	T wide;
+
+	for (unsigned i = 0; i < 2000; ++i) {
+		unsigned count = rng() % (wide_bits + 1);
+		W expected = 0;
+		for (unsigned todo = count; todo; ) {
+			unsigned bits = std::min(todo, base_bits);
+			expected = (expected << bits) | reference.Iterate(bits);
+			todo -= bits;
+		}
+		BOOST_REQUIRE((expected == wide.template IterateWide<W>(count)));
+		BOOST_REQUIRE(reference.GetRegisterState() == wide.GetRegisterState());
+	}
+
+	W words[7];
+	wide.IterateWords(words, 7);
+	for (unsigned i = 0; i < 7; ++i)
+		BOOST_REQUIRE((words[i] == reference.template IterateWide<W, 1>()));
+}
+
+template <class T>
+void test_lfsr_wides()
+{
+	printf("%u bits: wide output\n", T::cWidth);
+	test_lfsr_wide<T, uint8_t>();
+	test_lfsr_wide<T, uint32_t>();
+	test_lfsr_wide<T, uint64_t>();
+#ifdef __SIZEOF_INT128__
+	test_lfsr_wide<T, unsigned __int128>();
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(lfsr_wide)
+{
+	test_lfsr_wides<embedded_drivers::LfsrDefault4>();
+	test_lfsr_wides<embedded_drivers::LfsrDefault8>();
+	test_lfsr_wides<embedded_drivers::LfsrDefault16>();
+	test_lfsr_wides<embedded_drivers::LfsrDefault17>();
+	test_lfsr_wides<embedded_drivers::LfsrDefault32>();
+	test_lfsr_wides<embedded_drivers::LfsrDefault64>();
+#ifdef __SIZEOF_INT128__
+	test_lfsr_wides<embedded_drivers::LfsrDefault128>();
+#endif
+}
+
+template <class T, class R>
+void test_lfsr_random_bit_generator()
+{
+	printf("%u bits: random bit generator, %u bit words\n", T::cWidth, unsigned(8 * sizeof(R)));
+
+	typedef embedded_drivers::LfsrRandomBitGenerator<T, R, 5> Generator;
+	static_assert(std::is_same<decltype(std::declval<Generator&>()()), R>::value, "");
+	static_assert(Generator::min() == 0, "");
+	static_assert(Generator::max() == R(~R(0)), "");
+
+	// the generator emits the plain LFSR stream
+	Generator generator;
+	T reference;
+	for (unsigned i = 0; i < 23; ++i)
+		BOOST_REQUIRE(generator() == reference.template IterateWide<R>());
+
+	// usable with <random> and <algorithm>
+	std::uniform_int_distribution<int> distribution(-3, 3);
+	for (unsigned i = 0; i < 1000; ++i) {
+		int x = distribution(generator);
+		BOOST_REQUIRE((x >= -3) && (x <= 3));
+	}
+	std::vector<int> shuffled(100);
+	std::iota(shuffled.begin(), shuffled.end(), 0);
+	std::shuffle(shuffled.begin(), shuffled.end(), generator);
+	std::vector<int> sorted(shuffled);
+	std::sort(sorted.begin(), sorted.end());
+	for (int i = 0; i < 100; ++i)
+		BOOST_REQUIRE(sorted[i] == i);
+
+	// bounded integers are in range and roughly uniform
+	const uint32_t range = 10;
+	const unsigned samples = 100000;
+	unsigned histogram[range] = {};
+	for (unsigned i = 0; i < samples; ++i) {
+		uint32_t x = generator.Bounded(range);
+		BOOST_REQUIRE(x < range);
+		++histogram[x];
+	}
+	for (uint32_t i = 0; i < range; ++i)
+		BOOST_REQUIRE((histogram[i] > samples / range * 9 / 10) && (histogram[i] < samples / range * 11 / 10));
+	BOOST_REQUIRE(generator.Bounded(1) == 0);
+
+	double float_sum = 0;
+	double double_sum = 0;
+	for (unsigned i = 0; i < samples; ++i) {
+		float f = generator.Float();
+		double d = generator.Double();
+		BOOST_REQUIRE((f >= 0.0f) && (f < 1.0f));
+		BOOST_REQUIRE((d >= 0.0) && (d < 1.0));
+		float_sum += f;
+		double_sum += d;
+	}
+	BOOST_REQUIRE(std::abs(float_sum / samples - 0.5) < 0.01);
+	BOOST_REQUIRE(std::abs(double_sum / samples - 0.5) < 0.01);
+}
+
+BOOST_AUTO_TEST_CASE(lfsr_random_bit_generator)
+{
+	test_lfsr_random_bit_generator<embedded_drivers::LfsrDefault32, uint32_t>();
+	test_lfsr_random_bit_generator<embedded_drivers::LfsrDefault32, uint64_t>();
+	test_lfsr_random_bit_generator<embedded_drivers::LfsrDefault64, uint64_t>();
 }
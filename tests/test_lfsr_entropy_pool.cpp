@@ -0,0 +1,138 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Main
+#include <boost/test/included/unit_test.hpp>
+
+#include "embedded_drivers/lfsr_entropy_pool.h"
+#include "embedded_drivers/nrfx/lfsr_rng.h"
+#include "nrfx_rng.h"
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using embedded_drivers::LfsrEntropyPool;
+using embedded_drivers::LfsrFibonacci;
+using embedded_drivers::LfsrDefault32;
+
+
+BOOST_AUTO_TEST_CASE(entropy_pool_folds_batches)
+{
+	LfsrEntropyPool<LfsrDefault32, 16> pool;
+	LfsrDefault32 reference;
+
+	BOOST_REQUIRE(pool.cBatchBytes == 4);
+
+	// a partial batch is not folded in by Iterate()
+	for (uint8_t b : { 0x12, 0x34, 0x56 })
+		BOOST_REQUIRE(pool.Push(b));
+	BOOST_REQUIRE(pool.Pending() == 3);
+	BOOST_REQUIRE(pool.Iterate(8) == reference.Iterate(8));
+	BOOST_REQUIRE(pool.Pending() == 3);
+
+	// a full batch is, through the input path of Iterate()
+	BOOST_REQUIRE(pool.Push(0x78));
+	BOOST_REQUIRE(pool.Iterate(8) == (reference.Iterate(32, 0x12345678), reference.Iterate(8)));
+	BOOST_REQUIRE(pool.Pending() == 0);
+
+	// Reseed() also folds partial batches
+	BOOST_REQUIRE(pool.Push(0x9a));
+	BOOST_REQUIRE(pool.Push(0xbc));
+	pool.Reseed();
+	reference.Iterate(16, 0x9abc);
+	BOOST_REQUIRE(pool.Pending() == 0);
+	BOOST_REQUIRE(pool.GetRegisterState() == reference.GetRegisterState());
+}
+
+BOOST_AUTO_TEST_CASE(entropy_pool_drops_when_full)
+{
+	LfsrEntropyPool<LfsrFibonacci, 8> pool;
+
+	for (unsigned i = 0; i < 8; ++i)
+		BOOST_REQUIRE(pool.Push(i));
+	BOOST_REQUIRE(!pool.Push(8));
+	BOOST_REQUIRE(!pool.Push(9));
+	BOOST_REQUIRE(pool.Dropped() == 2);
+	BOOST_REQUIRE(pool.Pending() == 8);
+
+	pool.Reseed();
+	BOOST_REQUIRE(pool.Pending() == 0);
+	BOOST_REQUIRE(pool.Push(10));
+}
+
+BOOST_AUTO_TEST_CASE(entropy_pool_never_reaches_zero_state)
+{
+	LfsrEntropyPool<LfsrFibonacci, 8> pool;
+
+	// shift in exactly the register contents
+	uint16_t state = pool.GetRegisterState();
+	pool.Push(state >> 8);
+	pool.Push(state & 0xff);
+	pool.Reseed();
+	BOOST_REQUIRE(pool.GetRegisterState() != 0);
+}
+
+BOOST_AUTO_TEST_CASE(entropy_pool_concurrent)
+{
+	LfsrEntropyPool<LfsrDefault32, 64> pool;
+	std::atomic<bool> done(false);
+	std::atomic<unsigned> iterations(0);
+	const unsigned pushes = 20000;
+	unsigned pushed = 0;
+
+	std::thread producer([&]() {
+		for (unsigned i = 0; i < pushes; ++i)
+			if (pool.Push(uint8_t(i * 37 + 1)))
+				++pushed;
+			else
+				std::this_thread::yield();
+		done = true;
+	});
+
+	// consumers yield, so a single CPU host still gets to the producer
+	std::vector<std::thread> consumers;
+	for (unsigned t = 0; t < 3; ++t)
+		consumers.emplace_back([&]() {
+			while (!done) {
+				pool.Iterate(8);
+				++iterations;
+				std::this_thread::yield();
+			}
+		});
+
+	producer.join();
+	for (auto & consumer : consumers)
+		consumer.join();
+	pool.Reseed();
+
+	printf("pushed %u, dropped %u\n", pushed, unsigned(pool.Dropped()));
+	BOOST_REQUIRE(pushed > 0);
+	BOOST_REQUIRE(pushed + pool.Dropped() == pushes);
+	BOOST_REQUIRE(pool.Pending() == 0);
+	BOOST_REQUIRE(pool.GetRegisterState() != 0);
+
+	// Both the consumers and folding advance the register 8 bits per byte.
+	// Without the pushed bytes shifted in, it would end up here.
+	LfsrDefault32 unseeded;
+	for (unsigned i = 0; i < iterations + pushed; ++i)
+		unseeded.Iterate(8);
+	BOOST_REQUIRE(pool.GetRegisterState() != unseeded.GetRegisterState());
+}
+
+BOOST_AUTO_TEST_CASE(nrfx_lfsr_rng)
+{
+	lfsr_rng_init();
+	BOOST_REQUIRE(nrfx_rng_stub.started);
+	BOOST_REQUIRE(nrfx_rng_stub.config.interrupt_priority == NRFX_RNG_CONFIG_IRQ_PRIORITY);
+
+	LfsrFibonacci reference(lfsr_rng.GetRegisterState());
+	BOOST_REQUIRE(nrfx_rng_stub_irq(0xab));
+	BOOST_REQUIRE(nrfx_rng_stub_irq(0xcd));
+	BOOST_REQUIRE(lfsr_rng.Pending() == 2);
+
+	reference.Iterate(16, 0xabcd);
+	BOOST_REQUIRE(lfsr_rng.Iterate(16) == reference.Iterate(16));
+
+	lfsr_rng_deinit();
+	BOOST_REQUIRE(!nrfx_rng_stub_irq(0x01));
+}
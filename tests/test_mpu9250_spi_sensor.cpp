@@ -0,0 +1,239 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Main
+#include <boost/test/included/unit_test.hpp>
+
+#include "embedded_drivers/mpu9250_spi_sensor.h"
+
+#include <cstring>
+#include <deque>
+#include <vector>
+
+using namespace embedded_drivers;
+
+
+// Fake MPU-9250 on the SPI bus: register file with auto-increment, except
+// for FIFO_R_W, and a FIFO filled by Sample().
+struct FakeMpu9250 {
+	uint8_t regs[128];
+	std::deque<uint8_t> fifo;
+	unsigned samples;
+	unsigned transfers;
+	unsigned failIn;
+
+	FakeMpu9250()
+		: samples(0)
+		, transfers(0)
+		, failIn(0)
+	{
+		memset(regs, 0, sizeof(regs));
+	}
+
+	static int16_t Value(unsigned sample, unsigned field)
+	{
+		return int16_t(sample * 7 + field * 1000 - 3000);
+	}
+
+	// the sensor takes a sample, fields in register order
+	void Sample(void)
+	{
+		++samples;
+		if(!(regs[0x6a] & (1<<6)))
+			return;
+		uint8_t en = regs[0x23];
+		std::vector<int16_t> values;
+		if(en & (1<<3))
+			for(unsigned i = 0; i < 3; ++i)
+				values.push_back(Value(samples, i));
+		if(en & (1<<7))
+			values.push_back(Value(samples, 3));
+		for(unsigned i = 0; i < 3; ++i)
+			if(en & ((1<<6) >> i))
+				values.push_back(Value(samples, 4 + i));
+		for(int16_t v : values) {
+			fifo.push_back(uint16_t(v) >> 8);
+			fifo.push_back(uint8_t(v));
+		}
+		// the oldest data is replaced
+		while(fifo.size() > 512) {
+			fifo.pop_front();
+			regs[0x3a] |= (1<<4);
+		}
+	}
+
+	uint8_t Read(uint8_t reg)
+	{
+		switch(reg) {
+			case 0x3a: {
+				uint8_t status = regs[reg];
+				regs[reg] = 0;
+				return status;
+			}
+			case 0x72:
+				return fifo.size() >> 8;
+			case 0x73:
+				return uint8_t(fifo.size());
+			case 0x74: {
+				if(fifo.empty())
+					return 0xff;
+				uint8_t byte = fifo.front();
+				fifo.pop_front();
+				return byte;
+			}
+			default:
+				return regs[reg];
+		}
+	}
+
+	void Write(uint8_t reg, uint8_t value)
+	{
+		regs[reg] = value;
+		if(reg == 0x6a && (value & (1<<2))) {
+			fifo.clear();
+			regs[reg] &= ~(1<<2);
+		}
+	}
+};
+
+static bool fake_xfer(void * context, uint8_t const * tx_buf, size_t tx_size, uint8_t * rx_buf, size_t rx_size)
+{
+	FakeMpu9250 * fake = (FakeMpu9250 *)context;
+	BOOST_REQUIRE(tx_size >= 1);
+	BOOST_REQUIRE(rx_size >= tx_size);
+	++fake->transfers;
+	if(fake->failIn && !--fake->failIn)
+		return false;
+
+	bool read = tx_buf[0] & 0x80;
+	uint8_t reg = tx_buf[0] & 0x7f;
+	rx_buf[0] = 0;
+	for(size_t i = 1; i < rx_size; ++i) {
+		if(read)
+			rx_buf[i] = fake->Read(reg);
+		else
+			fake->Write(reg, (i < tx_size) ? tx_buf[i] : 0xff);
+		if(reg != 0x74)
+			reg = (reg + 1) & 0x7f;
+	}
+	return true;
+}
+
+BOOST_AUTO_TEST_CASE(mpu9250_fifo_burst)
+{
+	FakeMpu9250 fake;
+	Mpu9250SpiSensor sensor(&fake, fake_xfer);
+
+	// 1kHz / (1+1)
+	BOOST_REQUIRE(sensor.SetSampleRate(1));
+	BOOST_REQUIRE(fake.regs[0x19] == 1);
+	BOOST_REQUIRE((fake.regs[0x1a] & 7) == 1);
+	BOOST_REQUIRE(sensor.FifoEnable(sensor.regFifoEn_Accel | sensor.regFifoEn_Gyro));
+	BOOST_REQUIRE(fake.regs[0x23] == 0x78);
+	BOOST_REQUIRE(fake.regs[0x6a] & (1<<6));
+	BOOST_REQUIRE(sensor.FifoFrameSize() == 12);
+	BOOST_REQUIRE(sensor.SamplePeriodNsecs() == 2000000);
+
+	uint8_t buffer[1 + Mpu9250SpiSensor::cFifoSize];
+	unsigned frames;
+	bool overflow;
+	Mpu9250SpiSensor::FifoSample sample;
+
+	// 40 samples in three transfers: count, burst, status
+	for(unsigned i = 0; i < 40; ++i)
+		fake.Sample();
+	unsigned transfers = fake.transfers;
+	BOOST_REQUIRE(sensor.FifoRead(buffer, sizeof(buffer), &frames, &overflow, 100000));
+	BOOST_REQUIRE(fake.transfers - transfers == 3);
+	BOOST_REQUIRE(frames == 40);
+	BOOST_REQUIRE(!overflow);
+	BOOST_REQUIRE(fake.fifo.empty());
+	for(unsigned i = 0; i < frames; ++i) {
+		sensor.FifoUnpack(buffer, i, &sample);
+		unsigned n = fake.samples - frames + 1 + i;
+		BOOST_REQUIRE(sample.accel[0] == FakeMpu9250::Value(n, 0));
+		BOOST_REQUIRE(sample.accel[2] == FakeMpu9250::Value(n, 2));
+		BOOST_REQUIRE(sample.temp == 0);
+		BOOST_REQUIRE(sample.gyro[0] == FakeMpu9250::Value(n, 4));
+		BOOST_REQUIRE(sample.gyro[2] == FakeMpu9250::Value(n, 6));
+		BOOST_REQUIRE(sample.timestampUsecs == 100000 - 2000 * (frames - 1 - i));
+	}
+
+	// a small buffer takes whole frames, the rest stays in the FIFO
+	for(unsigned i = 0; i < 10; ++i)
+		fake.Sample();
+	BOOST_REQUIRE(sensor.FifoRead(buffer, 1 + 12 * 4 + 5, &frames, &overflow, 120000));
+	BOOST_REQUIRE(frames == 4);
+	BOOST_REQUIRE(fake.fifo.size() == 6 * 12);
+	sensor.FifoUnpack(buffer, 3, &sample);
+	BOOST_REQUIRE(sample.accel[1] == FakeMpu9250::Value(fake.samples - 6, 1));
+	// timed back from the newest frame still in the FIFO
+	BOOST_REQUIRE(sample.timestampUsecs == 120000 - 6 * 2000);
+	BOOST_REQUIRE(sensor.FifoRead(buffer, sizeof(buffer), &frames, &overflow, 120000));
+	BOOST_REQUIRE(frames == 6);
+	sensor.FifoUnpack(buffer, 0, &sample);
+	BOOST_REQUIRE(sample.accel[0] == FakeMpu9250::Value(fake.samples - 5, 0));
+	BOOST_REQUIRE(sample.timestampUsecs == 120000 - 5 * 2000);
+
+	// an overflow misaligns the frames, they are dropped and the FIFO reset
+	for(unsigned i = 0; i < 50; ++i)
+		fake.Sample();
+	BOOST_REQUIRE(sensor.FifoRead(buffer, sizeof(buffer), &frames, &overflow, 200000));
+	BOOST_REQUIRE(overflow);
+	BOOST_REQUIRE(frames == 0);
+	BOOST_REQUIRE(fake.fifo.empty());
+	fake.Sample();
+	BOOST_REQUIRE(sensor.FifoRead(buffer, sizeof(buffer), &frames, &overflow, 200000));
+	BOOST_REQUIRE(!overflow);
+	BOOST_REQUIRE(frames == 1);
+	sensor.FifoUnpack(buffer, 0, &sample);
+	BOOST_REQUIRE(sample.gyro[1] == FakeMpu9250::Value(fake.samples, 5));
+
+	// temperature and a single gyro axis, at the 8kHz rate without DLPF
+	fake.regs[0x1a] = 0;
+	BOOST_REQUIRE(sensor.FifoEnable(sensor.regFifoEn_Temp | sensor.regFifoEn_Gyro_Y));
+	BOOST_REQUIRE(sensor.FifoFrameSize() == 4);
+	BOOST_REQUIRE(sensor.SamplePeriodNsecs() == 125000);
+	fake.Sample();
+	BOOST_REQUIRE(sensor.FifoRead(buffer, sizeof(buffer), &frames, &overflow, 0));
+	BOOST_REQUIRE(frames == 1);
+	sensor.FifoUnpack(buffer, 0, &sample);
+	BOOST_REQUIRE(sample.accel[0] == 0);
+	BOOST_REQUIRE(sample.temp == FakeMpu9250::Value(fake.samples, 3));
+	BOOST_REQUIRE(sample.gyro[0] == 0);
+	BOOST_REQUIRE(sample.gyro[1] == FakeMpu9250::Value(fake.samples, 5));
+
+	// dividers that do not divide 1kHz evenly
+	BOOST_REQUIRE(sensor.SetSampleRate(2));
+	BOOST_REQUIRE(sensor.FifoEnable(sensor.regFifoEn_Accel));
+	BOOST_REQUIRE(sensor.SamplePeriodNsecs() == 3000000);
+	BOOST_REQUIRE(sensor.SetSampleRate(255));
+	BOOST_REQUIRE(sensor.FifoEnable(sensor.regFifoEn_Accel));
+	BOOST_REQUIRE(sensor.SamplePeriodNsecs() == 256000000);
+	for(unsigned i = 0; i < 3; ++i)
+		fake.Sample();
+	BOOST_REQUIRE(sensor.FifoRead(buffer, sizeof(buffer), &frames, &overflow, 1000000));
+	BOOST_REQUIRE(frames == 3);
+	sensor.FifoUnpack(buffer, 0, &sample);
+	BOOST_REQUIRE(sample.timestampUsecs == 1000000 - 2 * 256000);
+
+	// a failed write leaves the layout the sensor actually has
+	BOOST_REQUIRE(sensor.SetSampleRate(1));
+	unsigned before = fake.transfers;
+	BOOST_REQUIRE(sensor.FifoEnable(sensor.regFifoEn_Accel));
+	unsigned enableTransfers = fake.transfers - before;
+	fake.failIn = 1;
+	BOOST_REQUIRE(!sensor.FifoEnable(sensor.regFifoEn_Temp));
+	BOOST_REQUIRE(sensor.FifoFrameSize() == 6);
+	BOOST_REQUIRE(sensor.SamplePeriodNsecs() == 2000000);
+	fake.failIn = enableTransfers - 1;
+	BOOST_REQUIRE(!sensor.FifoEnable(sensor.regFifoEn_Temp));
+	BOOST_REQUIRE(sensor.FifoFrameSize() == 0);
+	BOOST_REQUIRE(!(fake.regs[0x6a] & (1<<6)));
+	fake.failIn = enableTransfers;
+	BOOST_REQUIRE(!sensor.FifoEnable(sensor.regFifoEn_Temp));
+	BOOST_REQUIRE(sensor.FifoFrameSize() == 2);
+	BOOST_REQUIRE(fake.regs[0x6a] & (1<<6));
+
+	BOOST_REQUIRE(sensor.FifoDisable());
+	BOOST_REQUIRE(!(fake.regs[0x6a] & (1<<6)));
+	BOOST_REQUIRE(fake.regs[0x23] == 0);
+}
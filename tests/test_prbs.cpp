@@ -0,0 +1,124 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Main
+#include <boost/test/included/unit_test.hpp>
+
+#include "embedded_drivers/prbs.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace embedded_drivers;
+
+
+// Reference generator, straight from the ITU-T O.150 shift register description.
+static std::vector<uint8_t> reference_prbs(unsigned width, unsigned tap, size_t len)
+{
+	std::vector<uint8_t> out(len);
+	uint32_t reg = (1u << width) - 1;
+	for (size_t i = 0; i < len; ++i)
+		for (unsigned b = 0; b < 8; ++b) {
+			uint32_t bit = ((reg >> (width - 1)) ^ (reg >> (tap - 1))) & 1;
+			reg = ((reg << 1) | bit) & ((1u << width) - 1);
+			out[i] = (out[i] << 1) | bit;
+		}
+	return out;
+}
+
+template <class LFSR>
+static void check_prbs(unsigned width, unsigned tap)
+{
+	const size_t len = 4099;
+	std::vector<uint8_t> reference = reference_prbs(width, tap, len);
+	std::vector<uint8_t> generated(len);
+
+	PrbsGenerator<LFSR> generator;
+	generator.Fill(generated.data(), 5);
+	generator.Fill(generated.data() + 5, len - 5);
+	BOOST_REQUIRE(generated == reference);
+
+	// locks after the first cWidth bits, from any byte offset
+	for (size_t offset : { 0, 3, 1000 }) {
+		PrbsChecker<LFSR> checker;
+		BOOST_REQUIRE(checker.Check(generated.data() + offset, len - offset) == 0);
+		BOOST_REQUIRE(checker.IsLocked());
+		BOOST_REQUIRE(checker.GetCheckedBits() == 8 * (len - offset - (width + 7) / 8));
+	}
+
+	// every flipped bit counts once
+	std::vector<uint8_t> corrupted = generated;
+	corrupted[100] ^= 0x81;
+	corrupted[2000] ^= 0x10;
+	corrupted[len - 1] ^= 0x01;
+	PrbsChecker<LFSR> checker;
+	BOOST_REQUIRE(checker.Check(corrupted.data(), 64) == 0);
+	BOOST_REQUIRE(checker.Check(corrupted.data() + 64, len - 64) == 4);
+	BOOST_REQUIRE(checker.GetBitErrors() == 4);
+	BOOST_REQUIRE(checker.GetSyncLosses() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(prbs_sequences)
+{
+	check_prbs<LfsrPrbs7>(7, 6);
+	check_prbs<LfsrPrbs15>(15, 14);
+	check_prbs<LfsrPrbs23>(23, 18);
+	check_prbs<LfsrPrbs31>(31, 28);
+}
+
+BOOST_AUTO_TEST_CASE(prbs_checker_resync)
+{
+	const size_t len = 1024;
+	std::vector<uint8_t> stream(2 * len);
+	PrbsGenerator<LfsrPrbs31> first;
+	PrbsGenerator<LfsrPrbs31> second(0x12345678);
+	first.Fill(stream.data(), len);
+	second.Fill(stream.data() + len, len);
+
+	PrbsChecker<LfsrPrbs31> checker;
+	checker.Check(stream.data(), stream.size());
+	BOOST_REQUIRE(checker.IsLocked());
+	BOOST_REQUIRE(checker.GetSyncLosses() == 1);
+
+	// locked onto the second sequence again, no errors after that
+	uint64_t errors = checker.GetBitErrors();
+	std::vector<uint8_t> more(len);
+	second.Fill(more.data(), len);
+	BOOST_REQUIRE(checker.Check(more.data(), len) == 0);
+	BOOST_REQUIRE(checker.GetBitErrors() == errors);
+}
+
+BOOST_AUTO_TEST_CASE(prbs_checker_stuck_line)
+{
+	std::vector<uint8_t> zeros(256, 0x00);
+	std::vector<uint8_t> ones(256, 0xff);
+
+	PrbsChecker<LfsrPrbs15> checker;
+	checker.Check(zeros.data(), zeros.size());
+	BOOST_REQUIRE(!checker.IsLocked());
+	BOOST_REQUIRE(checker.GetCheckedBits() == 0);
+
+	checker.Check(ones.data(), ones.size());
+	BOOST_REQUIRE(checker.GetSyncLosses() > 0);
+	BOOST_REQUIRE(checker.GetBitErrors() * 8 > checker.GetCheckedBits());
+}
+
+static unsigned xfer_count;
+static bool fake_loopback(void * spi_context, uint8_t const * tx_buf, size_t tx_size, uint8_t * rx_buf, size_t rx_size)
+{
+	BOOST_REQUIRE(tx_size == rx_size);
+	memcpy(rx_buf, tx_buf, rx_size);
+	if (xfer_count++ == 3)
+		rx_buf[7] ^= 0x04;
+	return spi_context == &xfer_count;
+}
+
+BOOST_AUTO_TEST_CASE(prbs_spi_loopback)
+{
+	PrbsSpiLoopback<LfsrPrbs23, 32> loopback(&xfer_count, fake_loopback);
+	BOOST_REQUIRE(loopback.Run(1000));
+	BOOST_REQUIRE(xfer_count == 32);
+	BOOST_REQUIRE(loopback.GetChecker().IsLocked());
+	BOOST_REQUIRE(loopback.GetChecker().GetBitErrors() == 1);
+
+	PrbsSpiLoopback<LfsrPrbs23, 32> broken(NULL, fake_loopback);
+	BOOST_REQUIRE(!broken.Run(10));
+}
@@ -0,0 +1,1204 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Main
+#include <boost/test/included/unit_test.hpp>
+
+#include "embedded_drivers/ssd1306_i2c_display.h"
+#include "embedded_drivers/ssd1306_frame_scheduler.h"
+#include "embedded_drivers/ssd1306_animation.h"
+#include "embedded_drivers/ssd1306_gray_surface.h"
+#include "embedded_drivers/ssd1306_compositor.h"
+#include "embedded_drivers/tools/ssd1306_animation_encoder.h"
+#include "embedded_drivers/font_tama_mini02.h"
+#include "embedded_drivers/lfsr.h"
+#include "ssd1306_emulator.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using namespace embedded_drivers;
+
+
+// Counts heap allocations, see ssd1306_allocation_free. All forms are
+// replaced and share out of line helpers, so the compiler does not see a
+// pointer from one operator new handed to free() or another delete.
+static size_t allocations;
+
+__attribute__((noinline)) static void * counted_alloc(size_t size)
+{
+	++allocations;
+	if(void * p = malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+__attribute__((noinline)) static void counted_free(void * p)
+{
+	free(p);
+}
+
+void * operator new(size_t size)			{ return counted_alloc(size); }
+void * operator new[](size_t size)			{ return counted_alloc(size); }
+void operator delete(void * p) noexcept			{ counted_free(p); }
+void operator delete(void * p, size_t) noexcept		{ counted_free(p); }
+void operator delete[](void * p) noexcept		{ counted_free(p); }
+void operator delete[](void * p, size_t) noexcept	{ counted_free(p); }
+
+
+template<class DISPLAY>
+struct TestDisplayT {
+	Ssd1306Emulator panel;
+	uint8_t framebuffer[DISPLAY::cFramebufferSize];
+	DISPLAY display;
+
+	TestDisplayT(bool buffered, uint8_t const * font = font_tama_mini02::dataptr)
+		: display(&panel, Ssd1306Emulator::Sleep, &panel, Ssd1306Emulator::Tx, Ssd1306Emulator::Rx,
+				font, false, buffered ? framebuffer : NULL)
+	{
+	}
+
+	~TestDisplayT()
+	{
+		BOOST_CHECK(panel.mErrors == 0);
+	}
+};
+
+typedef TestDisplayT<Ssd1306I2cDisplay> TestDisplay;
+
+BOOST_AUTO_TEST_CASE(ssd1306_shadow_matches_direct)
+{
+	TestDisplay direct(false);
+	TestDisplay shadow(true);
+	BOOST_REQUIRE(direct.panel.SameImage(shadow.panel));
+
+	static char const * const snippets[] = {
+		"Hello", " world", "\r\n", "\n", "\r", "0123456789abcdefghijklmnopqrstuvwxyz",
+		"\x02", "\x03", "\x04", "\x01", "\f", "status: ok\r\n", "~", "\0",
+	};
+	LfsrDefault16 lfsr;
+	for(unsigned i = 0; i < 2000; ++i) {
+		char const * snippet = snippets[lfsr.Iterate(8) % (sizeof(snippets) / sizeof(snippets[0]))];
+		int len = std::max<int>(1, strlen(snippet));
+		BOOST_REQUIRE(direct.display.Write(snippet, len) == len);
+		BOOST_REQUIRE(shadow.display.Write(snippet, len) == len);
+		if(lfsr.Iterate(2) == 0) {
+			BOOST_REQUIRE(shadow.display.Flush());
+			BOOST_REQUIRE(direct.panel.SameImage(shadow.panel));
+		}
+	}
+	BOOST_REQUIRE(shadow.display.Flush());
+	BOOST_REQUIRE(direct.panel.SameImage(shadow.panel));
+}
+
+static void draw_status(Ssd1306I2cDisplay & display, unsigned value)
+{
+	char line[32];
+	display.CursorSetPosition(0, 0);
+	display.Puts("Status screen\r\n");
+	for(unsigned i = 0; i < 6; ++i) {
+		snprintf(line, sizeof(line), "sensor %u: %5u\r\n", i, (i == 3) ? value : 100 * i);
+		display.Puts(line);
+	}
+	display.Puts("all systems nominal");
+}
+
+BOOST_AUTO_TEST_CASE(ssd1306_shadow_sends_only_changes)
+{
+	TestDisplay direct(false);
+	TestDisplay shadow(true);
+
+	draw_status(direct.display, 1);
+	draw_status(shadow.display, 1);
+	shadow.display.Flush();
+	BOOST_REQUIRE(direct.panel.SameImage(shadow.panel));
+
+	size_t direct_bytes = direct.panel.mBytes;
+	size_t shadow_bytes = shadow.panel.mBytes;
+	draw_status(direct.display, 2);
+	draw_status(shadow.display, 2);
+	shadow.display.Flush();
+	BOOST_REQUIRE(direct.panel.SameImage(shadow.panel));
+	direct_bytes = direct.panel.mBytes - direct_bytes;
+	shadow_bytes = shadow.panel.mBytes - shadow_bytes;
+	BOOST_TEST_MESSAGE("status update: " << direct_bytes << " bytes direct, " << shadow_bytes << " bytes with shadow");
+	BOOST_REQUIRE(10 * shadow_bytes < direct_bytes);
+
+	// the panel already shows all of this
+	shadow_bytes = shadow.panel.mBytes;
+	draw_status(shadow.display, 2);
+	shadow.display.Flush();
+	BOOST_REQUIRE(shadow.panel.mBytes == shadow_bytes);
+
+	shadow.display.Clear();
+	shadow.display.Flush();
+	shadow_bytes = shadow.panel.mBytes;
+	shadow.display.Clear();
+	shadow.display.Flush();
+	BOOST_REQUIRE(shadow.panel.mBytes == shadow_bytes);
+}
+
+// Emulator behind a bus that drops one transfer on request.
+struct FlakyBus {
+	Ssd1306Emulator panel;
+	unsigned failIn = 0;
+
+	static bool Tx(void * context, uint8_t address, uint8_t const * buffer, size_t len)
+	{
+		FlakyBus * bus = static_cast<FlakyBus *>(context);
+		if(bus->failIn && !--bus->failIn)
+			return false;
+		return Ssd1306Emulator::Tx(&bus->panel, address, buffer, len);
+	}
+};
+
+BOOST_AUTO_TEST_CASE(ssd1306_shadow_bus_error)
+{
+	TestDisplay reference(true);
+	FlakyBus bus;
+	uint8_t framebuffer[Ssd1306I2cDisplay::cFramebufferSize];
+	Ssd1306I2cDisplay display(NULL, Ssd1306Emulator::Sleep, &bus, FlakyBus::Tx, Ssd1306Emulator::Rx,
+			font_tama_mini02::dataptr, false, framebuffer);
+	BOOST_REQUIRE(reference.panel.SameImage(bus.panel));
+
+	// a page row lost on the bus is sent again by the next flush
+	draw_status(reference.display, 1);
+	draw_status(display, 1);
+	BOOST_REQUIRE(reference.display.Flush());
+	bus.failIn = 3;
+	BOOST_REQUIRE(!display.Flush());
+	BOOST_REQUIRE(!reference.panel.SameImage(bus.panel));
+	BOOST_REQUIRE(display.HasChanges());
+	BOOST_REQUIRE(display.Flush());
+	BOOST_REQUIRE(reference.panel.SameImage(bus.panel));
+	BOOST_REQUIRE(!display.HasChanges());
+	BOOST_REQUIRE(bus.panel.mErrors == 0);
+}
+
+BOOST_AUTO_TEST_CASE(ssd1306_batched_commands)
+{
+	TestDisplay direct(false);
+
+	// Init() sends its configuration in one transfer, the clear in another
+	BOOST_REQUIRE(direct.panel.mCommandTransactions <= 3);
+
+	// cursor moves ride along with the next glyph
+	size_t transactions = direct.panel.mTransactions;
+	direct.display.CursorSetPosition(3, 2);
+	BOOST_REQUIRE(direct.panel.mTransactions == transactions);
+	direct.display.PutChar('x');
+	BOOST_REQUIRE(direct.panel.mTransactions == transactions + 1);
+
+	// as do line wraps in Write()
+	direct.display.CursorSetPosition(0, 0);
+	transactions = direct.panel.mTransactions;
+	std::string line(25, 'a');
+	line += "bb";
+	direct.display.Puts(line.c_str());
+	BOOST_REQUIRE(direct.panel.mTransactions - transactions <= 4);
+
+	// commands with visible effect are sent at once
+	transactions = direct.panel.mTransactions;
+	direct.display.ColorInvert();
+	BOOST_REQUIRE(direct.panel.mTransactions == transactions + 1);
+	direct.display.Flush();
+	BOOST_REQUIRE(direct.panel.mTransactions == transactions + 1);
+}
+
+BOOST_AUTO_TEST_CASE(ssd1306_allocation_free)
+{
+	for(bool buffered : { false, true }) {
+		TestDisplay test(buffered);
+		std::string text;
+		for(unsigned i = 0; i < 20; ++i)
+			text += "some text that wraps over lines\r\n\x02\x01";
+
+		size_t before = allocations;
+		test.display.Write(text.data(), text.size());
+		test.display.Clear();
+		test.display.Puts("more\fand\x03\x04more");
+		test.display.PutChar('x');
+		test.display.Flush();
+		size_t count = allocations - before;
+
+		BOOST_REQUIRE(count == 0);
+	}
+}
+
+// Asynchronous bus: transfers are started by the display and finished
+// later by Complete(), like the TWIM interrupt would.
+struct AsyncBus {
+	Ssd1306Emulator * panel;
+	Ssd1306I2cDisplay * display;
+	uint8_t const * buffer;
+	size_t len;
+	bool failNext;
+	unsigned completions;
+	bool lastSuccess;
+
+	static bool TxAsync(void * context, uint8_t address, uint8_t const * buffer, size_t len);
+
+	static void Completion(void * context, bool success)
+	{
+		AsyncBus * bus = static_cast<AsyncBus *>(context);
+		++bus->completions;
+		bus->lastSuccess = success;
+	}
+
+	// Finishes the running transfer, returns false if there is none.
+	bool Complete(void)
+	{
+		if(!buffer)
+			return false;
+		bool success = !failNext;
+		if(success)
+			panel->Transfer(buffer, len);
+		failNext = false;
+		buffer = NULL;
+		display->TxComplete(success);
+		return true;
+	}
+
+	void CompleteAll(void)
+	{
+		while(Complete())
+			;
+	}
+};
+
+static AsyncBus * async_bus;
+
+bool AsyncBus::TxAsync(void *, uint8_t address, uint8_t const * buffer, size_t len)
+{
+	BOOST_REQUIRE(address == 0x3c);
+	BOOST_REQUIRE(async_bus->buffer == NULL);
+	BOOST_REQUIRE(len <= 255);
+	async_bus->buffer = buffer;
+	async_bus->len = len;
+	return true;
+}
+
+struct AsyncTestDisplay : TestDisplay {
+	uint8_t frontBuffer[Ssd1306I2cDisplay::cFrontBufferSize];
+	AsyncBus bus;
+
+	AsyncTestDisplay()
+		: TestDisplay(true)
+		, bus{ &panel, &display, NULL, 0, false, 0, false }
+	{
+		async_bus = &bus;
+		display.SetAsyncTx(AsyncBus::TxAsync, frontBuffer, AsyncBus::Completion, &bus);
+	}
+};
+
+BOOST_AUTO_TEST_CASE(ssd1306_async_flush)
+{
+	TestDisplay sync(true);
+	AsyncTestDisplay async;
+	BOOST_REQUIRE(sync.panel.SameImage(async.panel));
+
+	// the flush sends a snapshot, drawing goes on while it runs
+	draw_status(sync.display, 1);
+	sync.display.Flush();
+	draw_status(async.display, 1);
+	BOOST_REQUIRE(async.display.FlushAsync());
+	BOOST_REQUIRE(async.display.IsFlushing());
+	size_t bytes = async.panel.mBytes;
+	async.display.Clear();
+	draw_status(async.display, 2);
+	BOOST_REQUIRE(!async.display.FlushAsync());
+	BOOST_REQUIRE(async.panel.mBytes == bytes);
+	async.bus.CompleteAll();
+	BOOST_REQUIRE(!async.display.IsFlushing());
+	BOOST_REQUIRE(async.bus.completions == 1 && async.bus.lastSuccess);
+	BOOST_REQUIRE(sync.panel.SameImage(async.panel));
+
+	draw_status(sync.display, 2);
+	sync.display.Flush();
+	BOOST_REQUIRE(async.display.FlushAsync());
+	async.bus.CompleteAll();
+	BOOST_REQUIRE(async.bus.completions == 2);
+	BOOST_REQUIRE(sync.panel.SameImage(async.panel));
+
+	// nothing to send completes at once
+	BOOST_REQUIRE(async.display.FlushAsync());
+	BOOST_REQUIRE(!async.display.IsFlushing());
+	BOOST_REQUIRE(async.bus.completions == 3);
+
+	// a failed flush is resent by the next one
+	async.display.Clear();
+	async.display.Puts("after a bus error");
+	BOOST_REQUIRE(async.display.FlushAsync());
+	async.bus.failNext = true;
+	async.bus.CompleteAll();
+	BOOST_REQUIRE(async.bus.completions == 4 && !async.bus.lastSuccess);
+	BOOST_REQUIRE(async.display.FlushAsync());
+	async.bus.CompleteAll();
+	BOOST_REQUIRE(async.bus.lastSuccess);
+	sync.display.Clear();
+	sync.display.Puts("after a bus error");
+	sync.display.Flush();
+	BOOST_REQUIRE(sync.panel.SameImage(async.panel));
+
+	// nothing waits for a running flush: commands stay queued, changes in
+	// the shadow, and TxComplete() outside of a flush does no harm
+	async.display.TxComplete(true);
+	async.display.Puts("!");
+	BOOST_REQUIRE(async.display.FlushAsync());
+	async.display.ColorInvert();
+	BOOST_REQUIRE(!async.panel.mInverse);
+	async.display.Puts("?");
+	BOOST_REQUIRE(!async.display.Flush());
+	BOOST_REQUIRE(!async.display.SetAsyncTx(AsyncBus::TxAsync, async.frontBuffer, AsyncBus::Completion, &async.bus));
+	async.bus.CompleteAll();
+	BOOST_REQUIRE(async.display.Flush());
+	BOOST_REQUIRE(async.panel.mInverse);
+	sync.display.Puts("!?");
+	sync.display.Flush();
+	BOOST_REQUIRE(sync.panel.SameImage(async.panel));
+
+	// commands beyond the queue wait for the flush, none is lost
+	async.display.Puts("#");
+	BOOST_REQUIRE(async.display.FlushAsync());
+	async.display.Off();
+	for(unsigned i = 0; i < 15; ++i) {
+		if(i % 2)
+			async.display.ColorInvert();
+		else
+			async.display.ColorNormal();
+	}
+	BOOST_REQUIRE(async.panel.mDisplayOn);
+	std::thread interrupt([&async]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		async.bus.CompleteAll();
+	});
+	async.display.ColorInvert();
+	interrupt.join();
+	// the last one is sent right after the queue
+	BOOST_REQUIRE(!async.panel.mDisplayOn);
+	BOOST_REQUIRE(async.panel.mInverse);
+	async.display.On();
+	BOOST_REQUIRE(async.panel.mDisplayOn);
+}
+
+struct TerminalDisplay : TestDisplay {
+	char lines[32 * 128];
+
+	TerminalDisplay(bool buffered)
+		: TestDisplay(buffered)
+	{
+		display.SetScrollback(lines, 32);
+	}
+};
+
+BOOST_AUTO_TEST_CASE(ssd1306_terminal_matches_plain)
+{
+	for(bool buffered : { false, true }) {
+		TestDisplay plain(false);
+		TerminalDisplay terminal(buffered);
+		terminal.display.Flush();
+		BOOST_REQUIRE(plain.panel.SameScreen(terminal.panel));
+
+		static char const * const snippets[] = {
+			"Hello", " world", "\r\n", "\n", "\r", "0123456789abcdefghijklmnopqrstuvwxyz",
+			"\x02", "\x03", "\x04", "\x01", "\f", "status: ok\r\n", "~", "\0",
+		};
+		LfsrDefault16 lfsr;
+		for(unsigned i = 0; i < 2000; ++i) {
+			char const * snippet = snippets[lfsr.Iterate(8) % (sizeof(snippets) / sizeof(snippets[0]))];
+			int len = std::max<int>(1, strlen(snippet));
+			BOOST_REQUIRE(plain.display.Write(snippet, len) == len);
+			BOOST_REQUIRE(terminal.display.Write(snippet, len) == len);
+			if(buffered)
+				BOOST_REQUIRE(terminal.display.Flush());
+			BOOST_REQUIRE(plain.panel.SameScreen(terminal.panel));
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(ssd1306_terminal_log_traffic)
+{
+	TestDisplay plain(false);
+	TerminalDisplay terminal(false);
+
+	char line[32];
+	size_t plainBytes = plain.panel.mBytes;
+	size_t plainTransactions = plain.panel.mTransactions;
+	size_t terminalBytes = terminal.panel.mBytes;
+	size_t terminalTransactions = terminal.panel.mTransactions;
+	for(unsigned i = 0; i < 200; ++i) {
+		snprintf(line, sizeof(line), "%s %u\r\n", (i % 3) ? "sample" : "event", i * 37);
+		plain.display.Puts(line);
+		terminal.display.Puts(line);
+	}
+	BOOST_REQUIRE(plain.panel.SameScreen(terminal.panel));
+	plainBytes = plain.panel.mBytes - plainBytes;
+	plainTransactions = plain.panel.mTransactions - plainTransactions;
+	terminalBytes = terminal.panel.mBytes - terminalBytes;
+	terminalTransactions = terminal.panel.mTransactions - terminalTransactions;
+	BOOST_TEST_MESSAGE("200 log lines: " << plainBytes << " bytes in " << plainTransactions << " transfers plain, "
+			<< terminalBytes << " bytes in " << terminalTransactions << " transfers as terminal");
+	BOOST_REQUIRE(3 * terminalBytes < 2 * plainBytes);
+	BOOST_REQUIRE(2 * terminalTransactions <= plainTransactions);
+
+	// lines that scroll off within one write are never sent
+	std::string burst;
+	for(unsigned i = 0; i < 50; ++i) {
+		snprintf(line, sizeof(line), "burst %u\r\n", i);
+		burst += line;
+	}
+	terminalBytes = terminal.panel.mBytes;
+	terminal.display.Puts(burst.c_str());
+	plain.display.Puts(burst.c_str());
+	BOOST_REQUIRE(plain.panel.SameScreen(terminal.panel));
+	BOOST_REQUIRE(terminal.panel.mBytes - terminalBytes < Ssd1306I2cDisplay::cFramebufferSize + 64);
+}
+
+BOOST_AUTO_TEST_CASE(ssd1306_terminal_scrollback)
+{
+	for(bool buffered : { false, true }) {
+		TerminalDisplay terminal(buffered);
+
+		char line[32];
+		for(unsigned i = 0; i < 30; ++i) {
+			snprintf(line, sizeof(line), "line %u\r\n", i);
+			terminal.display.Puts(line);
+		}
+		terminal.display.Flush();
+
+		// 23 lines scrolled off, the ring keeps 32 - 8 of them
+		for(unsigned back : { 1u, 2u, 5u, 23u, 0u, 100u }) {
+			size_t transactions = terminal.panel.mTransactions;
+			unsigned shown = terminal.display.ScrollBack(back);
+			BOOST_REQUIRE(shown == std::min(back, 23u));
+			terminal.display.Flush();
+
+			// lines 23 - shown .. 30 - shown are visible, line 30 is still empty
+			TestDisplay expected(false);
+			for(unsigned i = 23 - shown; i < std::min(30u, 31 - shown); ++i) {
+				snprintf(line, sizeof(line), "%sline %u", (i == 23 - shown) ? "" : "\r\n", i);
+				expected.display.Puts(line);
+			}
+			BOOST_REQUIRE(expected.panel.SameScreen(terminal.panel));
+
+			// scrolling by one line redraws only one page
+			if(back == 1 && !buffered)
+				BOOST_REQUIRE(terminal.panel.mTransactions == transactions + 1);
+		}
+		BOOST_REQUIRE(terminal.display.ScrollBack(0) == 0);
+
+		// back on the live screen
+		terminal.display.Puts("line 30");
+		terminal.display.Flush();
+		TestDisplay expected(false);
+		for(unsigned i = 23; i < 31; ++i) {
+			snprintf(line, sizeof(line), "%sline %u", (i == 23) ? "" : "\r\n", i);
+			expected.display.Puts(line);
+		}
+		BOOST_REQUIRE(expected.panel.SameScreen(terminal.panel));
+	}
+}
+
+template<class DISPLAY>
+static void check_panel(unsigned comPins, unsigned columnOffset)
+{
+	// only the shadow clears the pages that are not shown yet
+	TestDisplayT<DISPLAY> direct(false);
+	TestDisplayT<DISPLAY> shadow(true);
+	BOOST_REQUIRE(direct.panel.mMultiplex == DISPLAY::cDisplayHeight - 1);
+	BOOST_REQUIRE(direct.panel.mComPins == comPins);
+	BOOST_REQUIRE(shadow.panel.mComPins == comPins);
+
+	static char const * const snippets[] = {
+		"Hello", " world", "\r\n", "\n", "\r", "0123456789abcdefghijklmnopqrstuvwxyz",
+		"\x02", "\x03", "\x04", "\x01", "\f", "status: ok\r\n",
+	};
+	LfsrDefault16 lfsr;
+	for(unsigned i = 0; i < 1000; ++i) {
+		char const * snippet = snippets[lfsr.Iterate(8) % (sizeof(snippets) / sizeof(snippets[0]))];
+		direct.display.Puts(snippet);
+		shadow.display.Puts(snippet);
+		BOOST_REQUIRE(shadow.display.Flush());
+		BOOST_REQUIRE(direct.panel.SameScreen(shadow.panel, DISPLAY::cLineCount));
+	}
+
+	// nothing is drawn outside of the columns wired to the panel
+	for(unsigned page = 0; page < 8; ++page)
+		for(unsigned col = 0; col < 128; ++col)
+			if(col < columnOffset || col >= columnOffset + DISPLAY::cDisplayWidth)
+				BOOST_REQUIRE(direct.panel.mRam[page][col] == 0xa5);
+
+	// rows rotate through all RAM pages, the panel shows the last lines
+	direct.display.Clear();
+	char line[32];
+	for(unsigned i = 0; i < 11; ++i) {
+		snprintf(line, sizeof(line), "%sline %u", i ? "\r\n" : "", i);
+		direct.display.Puts(line);
+	}
+	TestDisplayT<DISPLAY> expected(false);
+	for(unsigned i = 11 - DISPLAY::cLineCount; i < 11; ++i) {
+		snprintf(line, sizeof(line), "%sline %u", (i == 11 - DISPLAY::cLineCount) ? "" : "\r\n", i);
+		expected.display.Puts(line);
+	}
+	BOOST_REQUIRE(expected.panel.SameScreen(direct.panel, DISPLAY::cLineCount));
+}
+
+BOOST_AUTO_TEST_CASE(ssd1306_panel_geometries)
+{
+	static_assert(Ssd1306I2cDisplay::cColumnCount == 25 && Ssd1306I2cDisplay::cLineCount == 8, "128x64");
+	static_assert(Ssd1306I2cDisplay128x32::cLineCount == 4, "128x32");
+	static_assert(Ssd1306I2cDisplay96x16::cColumnCount == 19 && Ssd1306I2cDisplay96x16::cLineCount == 2, "96x16");
+	static_assert(Ssd1306I2cDisplay64x48::cColumnCount == 12 && Ssd1306I2cDisplay64x48::cLineCount == 6, "64x48");
+
+	check_panel<Ssd1306I2cDisplay>(0x12, 0);
+	check_panel<Ssd1306I2cDisplay128x32>(0x02, 0);
+	check_panel<Ssd1306I2cDisplay96x16>(0x02, 0);
+	check_panel<Ssd1306I2cDisplay64x48>(0x12, 32);
+}
+
+// font_tama_mini02 scaled up, in page rows of column bytes per glyph
+template<unsigned SCALE>
+struct ScaledFont {
+	uint8_t data[96][SCALE][5 * SCALE];
+
+	ScaledFont()
+	{
+		for(unsigned c = 0; c < 96; ++c) {
+			for(unsigned col = 0; col < 5; ++col) {
+				uint8_t source = font_tama_mini02::dataptr[c * 5 + col];
+				uint32_t column = 0;
+				for(unsigned bit = 0; bit < 8; ++bit)
+					if((source >> bit) & 1)
+						column |= ((1u << SCALE) - 1) << (bit * SCALE);
+				for(unsigned row = 0; row < SCALE; ++row)
+					for(unsigned i = 0; i < SCALE; ++i)
+						data[c][row][col * SCALE + i] = column >> (8 * row);
+			}
+		}
+	}
+};
+
+template<class DISPLAY, unsigned SCALE>
+static void check_large_font(void)
+{
+	static ScaledFont<SCALE> font;
+	static unsigned const pages = DISPLAY::cDisplayHeight / 8;
+	TestDisplayT<DISPLAY> direct(false, &font.data[0][0][0]);
+	TestDisplayT<DISPLAY> shadow(true, &font.data[0][0][0]);
+	TestDisplayT<DISPLAY> terminal(false, &font.data[0][0][0]);
+	char lines[16 * 128];
+	terminal.display.SetScrollback(lines, 16);
+
+	// a chunk of text is one window, its page rows sent in one transfer
+	size_t transactions = direct.panel.mTransactions;
+	direct.display.Puts("AB");
+	BOOST_REQUIRE(direct.panel.mTransactions == transactions + 1);
+	for(unsigned row = 0; row < SCALE; ++row) {
+		BOOST_REQUIRE(!memcmp(&direct.panel.mRam[row][0], font.data['A' - ' '][row], 5 * SCALE));
+		BOOST_REQUIRE(!memcmp(&direct.panel.mRam[row][5 * SCALE], font.data['B' - ' '][row], 5 * SCALE));
+	}
+	shadow.display.Puts("AB");
+	terminal.display.Puts("AB");
+
+	static char const * const snippets[] = {
+		"Hello", " world", "\r\n", "\n", "\r", "0123456789abcdefghijklmnopqrstuvwxyz",
+		"\x02", "\x03", "\x04", "\x01", "\f", "status: ok\r\n",
+	};
+	LfsrDefault16 lfsr;
+	for(unsigned i = 0; i < 1000; ++i) {
+		char const * snippet = snippets[lfsr.Iterate(8) % (sizeof(snippets) / sizeof(snippets[0]))];
+		direct.display.Puts(snippet);
+		shadow.display.Puts(snippet);
+		terminal.display.Puts(snippet);
+		BOOST_REQUIRE(shadow.display.Flush());
+		BOOST_REQUIRE(direct.panel.SameScreen(shadow.panel, pages));
+		BOOST_REQUIRE(direct.panel.SameScreen(terminal.panel, pages));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(ssd1306_large_fonts)
+{
+	static_assert(Ssd1306I2cDisplay128x64Font10x16::cLineCount == 4, "16 pixel lines");
+	static_assert(Ssd1306I2cDisplay128x64Font15x24::cLineCount == 2, "24 pixel lines, 16 rows spare");
+
+	check_large_font<Ssd1306I2cDisplay128x64Font10x16, 2>();
+	check_large_font<Ssd1306I2cDisplay128x64Font15x24, 3>();
+	check_large_font<Ssd1306I2cDisplay128x32Font10x16, 2>();
+}
+
+// Per-pixel model of the raster graphics, for ssd1306_raster_matches_pixels.
+struct PixelScreen {
+	bool pixel[64][128];
+
+	PixelScreen()
+	{
+		memset(pixel, 0, sizeof(pixel));
+	}
+
+	void Plot(int x, int y, bool on, Ssd1306I2cDisplay::DrawMode mode)
+	{
+		if(x < 0 || x >= 128 || y < 0 || y >= 64)
+			return;
+		switch(mode) {
+			case Ssd1306I2cDisplay::DrawClear:
+				pixel[y][x] = pixel[y][x] && !on;
+				break;
+			case Ssd1306I2cDisplay::DrawSet:
+				pixel[y][x] = pixel[y][x] || on;
+				break;
+			case Ssd1306I2cDisplay::DrawInvert:
+				pixel[y][x] = pixel[y][x] != on;
+				break;
+			case Ssd1306I2cDisplay::DrawCopy:
+				pixel[y][x] = on;
+				break;
+		}
+	}
+
+	void Line(int x0, int y0, int x1, int y1, Ssd1306I2cDisplay::DrawMode mode)
+	{
+		int dx = abs(x1 - x0), dy = -abs(y1 - y0);
+		int sx = (x0 < x1) ? 1 : -1, sy = (y0 < y1) ? 1 : -1;
+		int err = dx + dy;
+		for(;;) {
+			Plot(x0, y0, true, mode);
+			if(x0 == x1 && y0 == y1)
+				break;
+			int e2 = 2 * err;
+			if(e2 >= dy) {
+				err += dy;
+				x0 += sx;
+			}
+			if(e2 <= dx) {
+				err += dx;
+				y0 += sy;
+			}
+		}
+	}
+
+	void Fill(int x, int y, int w, int h, Ssd1306I2cDisplay::DrawMode mode)
+	{
+		for(int row = y; row < y + h; ++row)
+			for(int col = x; col < x + w; ++col)
+				Plot(col, row, true, mode);
+	}
+
+	void Rect(int x, int y, int w, int h, Ssd1306I2cDisplay::DrawMode mode)
+	{
+		for(int row = y; row < y + h; ++row)
+			for(int col = x; col < x + w; ++col)
+				if(row == y || row == y + h - 1 || col == x || col == x + w - 1)
+					Plot(col, row, true, mode);
+	}
+
+	void Bitmap(int x, int y, uint8_t const * bitmap, int w, int h, Ssd1306I2cDisplay::DrawMode mode)
+	{
+		for(int row = 0; row < h; ++row)
+			for(int col = 0; col < w; ++col)
+				Plot(x + col, y + row, (bitmap[(row/8)*w + col] >> (row%8)) & 1, mode);
+	}
+
+	bool Shows(Ssd1306Emulator const & panel) const
+	{
+		for(unsigned y = 0; y < 64; ++y)
+			for(unsigned x = 0; x < 128; ++x)
+				if(pixel[y][x] != bool((panel.mRam[(panel.mStartLine/8 + y/8) % 8][x] >> (y%8)) & 1))
+					return false;
+		return true;
+	}
+};
+
+BOOST_AUTO_TEST_CASE(ssd1306_raster_matches_pixels)
+{
+	TestDisplay shadow(true);
+	shadow.display.Clear();
+	// rotate the view port, the graphics must follow it
+	shadow.display.Puts("\n\n\n\n\n\n\n\n\n\n\n");
+	BOOST_REQUIRE(shadow.display.Flush());
+	BOOST_REQUIRE(shadow.panel.mStartLine != 0);
+
+	PixelScreen screen;
+	BOOST_REQUIRE(screen.Shows(shadow.panel));
+
+	uint8_t bitmap[5 * 40];
+	LfsrDefault16 lfsr;
+	for(unsigned i = 0; i < sizeof(bitmap); ++i)
+		bitmap[i] = lfsr.Iterate(8);
+
+	for(unsigned i = 0; i < 3000; ++i) {
+		auto mode = Ssd1306I2cDisplay::DrawMode(lfsr.Iterate(2));
+		int x = int(lfsr.Iterate(8) % 160) - 16;
+		int y = int(lfsr.Iterate(7) % 96) - 16;
+		int w = lfsr.Iterate(6) % 48;
+		int h = lfsr.Iterate(6) % 40;
+		switch(lfsr.Iterate(3) % 5) {
+			case 0:
+				shadow.display.DrawPixel(x, y, mode);
+				screen.Plot(x, y, true, mode);
+				break;
+			case 1:
+				shadow.display.DrawLine(x, y, x + w - 24, y + h - 20, mode);
+				screen.Line(x, y, x + w - 24, y + h - 20, mode);
+				break;
+			case 2:
+				shadow.display.DrawRect(x, y, w, h, mode);
+				screen.Rect(x, y, w, h, mode);
+				break;
+			case 3:
+				shadow.display.FillRect(x, y, w, h, mode);
+				screen.Fill(x, y, w, h, mode);
+				break;
+			case 4:
+				w = std::min(w, 40);
+				shadow.display.DrawBitmap(x, y, bitmap, w, h, mode);
+				screen.Bitmap(x, y, bitmap, w, h, mode);
+				break;
+		}
+		if(lfsr.Iterate(3) == 0) {
+			BOOST_REQUIRE(shadow.display.Flush());
+			BOOST_REQUIRE(screen.Shows(shadow.panel));
+		}
+	}
+	BOOST_REQUIRE(shadow.display.Flush());
+	BOOST_REQUIRE(screen.Shows(shadow.panel));
+}
+
+BOOST_AUTO_TEST_CASE(ssd1306_raster_sends_only_changes)
+{
+	TestDisplay shadow(true);
+	shadow.display.Clear();
+	for(unsigned x = 0; x < 128; x += 16)
+		shadow.display.DrawLine(x, 0, 127 - x, 63);
+	shadow.display.DrawRect(10, 20, 100, 13);
+	shadow.display.FillRect(11, 21, 40, 11);
+	BOOST_REQUIRE(shadow.display.Flush());
+
+	// drawing the same again sends nothing
+	size_t bytes = shadow.panel.mBytes;
+	shadow.display.DrawRect(10, 20, 100, 13);
+	shadow.display.FillRect(11, 21, 40, 11);
+	BOOST_REQUIRE(shadow.display.Flush());
+	BOOST_REQUIRE(shadow.panel.mBytes == bytes);
+
+	// growing the bar sends just the new columns of its two pages
+	shadow.display.FillRect(11, 21, 44, 11);
+	BOOST_REQUIRE(shadow.display.Flush());
+	BOOST_TEST_MESSAGE("bar update: " << shadow.panel.mBytes - bytes << " bytes");
+	BOOST_REQUIRE(shadow.panel.mBytes - bytes < 40);
+}
+
+BOOST_AUTO_TEST_CASE(ssd1306_emulator_screen)
+{
+	TestDisplay direct(false);
+	TestDisplay shadow(true);
+	direct.display.Test();
+	shadow.display.Test();
+	BOOST_REQUIRE(shadow.display.Flush());
+	BOOST_REQUIRE(direct.panel.SameScreen(shadow.panel));
+	BOOST_REQUIRE(direct.panel.mSleepMsecs > 0);
+
+	direct.display.Clear();
+	direct.display.Puts("A");
+	BOOST_REQUIRE(direct.panel.mDisplayOn);
+	BOOST_REQUIRE(!direct.panel.Pixel(127, 63));
+	bool lit = false;
+	for(unsigned x = 0; x < 5; ++x)
+		for(unsigned y = 0; y < 8; ++y)
+			lit = lit || direct.panel.Pixel(x, y);
+	BOOST_REQUIRE(lit);
+
+	direct.display.ColorInvert();
+	BOOST_REQUIRE(direct.panel.Pixel(127, 63));
+	direct.display.ColorNormal();
+	direct.display.HideDisplay();
+	BOOST_REQUIRE(direct.panel.Pixel(127, 63));
+	direct.display.ShowDisplay();
+	direct.display.Off();
+	BOOST_REQUIRE(!direct.panel.Pixel(0, 0) && !direct.panel.Pixel(127, 63));
+	direct.display.On();
+
+	char path[] = "/tmp/ssd1306_emulatorXXXXXX";
+	int fd = mkstemp(path);
+	BOOST_REQUIRE(fd >= 0);
+	close(fd);
+	BOOST_REQUIRE(direct.panel.WritePbm(path));
+	FILE * file = fopen(path, "rb");
+	BOOST_REQUIRE(file);
+	unsigned width = 0, height = 0;
+	BOOST_REQUIRE(fscanf(file, "P4 %u %u", &width, &height) == 2);
+	fgetc(file);
+	uint8_t first = fgetc(file);
+	BOOST_REQUIRE(fseek(file, 0, SEEK_END) == 0);
+	long size = ftell(file);
+	fclose(file);
+	unlink(path);
+	BOOST_REQUIRE(width == 128 && height == 64);
+	BOOST_REQUIRE(size == long(strlen("P4\n128 64\n") + 16 * 64));
+	uint8_t expected = 0;
+	for(unsigned x = 0; x < 8; ++x)
+		expected = (expected << 1) | direct.panel.Pixel(x, 0);
+	BOOST_REQUIRE(first == expected);
+
+	// right scroll of pages 0..1, as the driver does not scroll itself
+	static uint8_t const scroll[] = { 0x00, 0x26, 0x00, 0x00, 0x07, 0x01, 0x00, 0xff, 0x2f };
+	uint8_t page0[128], page2[128];
+	memcpy(page0, direct.panel.mRam[0], 128);
+	memcpy(page2, direct.panel.mRam[2], 128);
+	direct.panel.Transfer(scroll, sizeof(scroll));
+	direct.panel.ScrollStep();
+	BOOST_REQUIRE(direct.panel.mRam[0][0] == page0[127]);
+	BOOST_REQUIRE(!memcmp(&direct.panel.mRam[0][1], page0, 127));
+	BOOST_REQUIRE(!memcmp(direct.panel.mRam[2], page2, 128));
+}
+
+BOOST_AUTO_TEST_CASE(ssd1306_frame_scheduler)
+{
+	TestDisplay direct(false);
+	TestDisplay shadow(true);
+	Ssd1306FrameScheduler<Ssd1306I2cDisplay> scheduler(shadow.display, 10);
+
+	// a status screen redrawn from 100 updates a second, for two seconds
+	size_t direct_bytes = direct.panel.mBytes;
+	size_t shadow_bytes = shadow.panel.mBytes;
+	uint32_t now = 0xfff00000;	// wraps meanwhile
+	scheduler.ResetStatistics(now);
+	for(unsigned ms = 0; ms < 2000; ++ms, now += 1000) {
+		if(ms % 10 == 0) {
+			draw_status(direct.display, ms / 100);
+			draw_status(shadow.display, ms / 100);
+		}
+		scheduler.Poll(now);
+	}
+	scheduler.FlushNow();
+	BOOST_REQUIRE(direct.panel.SameImage(shadow.panel));
+	direct_bytes = direct.panel.mBytes - direct_bytes;
+	shadow_bytes = shadow.panel.mBytes - shadow_bytes;
+	BOOST_TEST_MESSAGE("200 status updates: " << direct_bytes << " bytes direct, " << shadow_bytes
+			<< " bytes in " << scheduler.Frames() << " frames, bus "
+			<< scheduler.BusUtilization(now) / 10.0 << "% busy");
+	BOOST_REQUIRE(scheduler.Frames() <= 21);
+	BOOST_REQUIRE(scheduler.FramesDropped() == 0);
+	BOOST_REQUIRE(50 * shadow_bytes < direct_bytes);
+
+	// full screen changes on a slow bus, limited to 10% of its time
+	TestDisplay busy(true);
+	Ssd1306FrameScheduler<Ssd1306I2cDisplay> limited(busy.display, 50, 100000, 10);
+	now = 0;
+	limited.ResetStatistics(now);
+	for(unsigned ms = 0; ms < 5000; ++ms, now += 1000) {
+		busy.display.FillRect(0, 0, 128, 64, Ssd1306I2cDisplay::DrawInvert);
+		limited.Poll(now);
+	}
+	BOOST_TEST_MESSAGE("full screen at 50 fps: " << limited.Frames() << " frames, "
+			<< limited.FramesDropped() << " dropped, bus " << limited.BusUtilization(now) / 10.0 << "% busy");
+	BOOST_REQUIRE(limited.FramesDropped() > limited.Frames());
+	// the first frame is sent on credit
+	BOOST_REQUIRE(limited.BusUtilization(now) <= 100 + 1000 * limited.BusUsecs() / limited.Frames() / 5000000);
+	BOOST_REQUIRE(limited.BusUtilization(now) >= 80);
+
+	// a frame the bus fails on is dropped, not counted as sent
+	FlakyBus bus;
+	uint8_t framebuffer[Ssd1306I2cDisplay::cFramebufferSize];
+	Ssd1306I2cDisplay flaky(NULL, Ssd1306Emulator::Sleep, &bus, FlakyBus::Tx, Ssd1306Emulator::Rx,
+			font_tama_mini02::dataptr, false, framebuffer);
+	Ssd1306FrameScheduler<Ssd1306I2cDisplay> failing(flaky, 10);
+	failing.ResetStatistics(0);
+	draw_status(flaky, 1);
+	bus.failIn = 2;
+	BOOST_REQUIRE(!failing.FlushNow());
+	BOOST_REQUIRE(failing.Frames() == 0);
+	BOOST_REQUIRE(failing.FramesDropped() == 1);
+	BOOST_REQUIRE(failing.FlushNow());
+	BOOST_REQUIRE(failing.Frames() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(ssd1306_write_runs)
+{
+	std::string status =
+		"Status screen\r\nsensor 0:     0\r\nsensor 1:   100\r\nsensor 2:   200\r\n"
+		"sensor 3:   300\r\nsensor 4:   400\r\nsensor 5:   500\r\nall systems nominal";
+	std::string wrapped;
+	for(unsigned i = 0; i < 200; ++i)
+		wrapped += char('a' + i % 26);
+	std::string table;
+	for(unsigned i = 0; i < 8; ++i)
+		table += "row " + std::to_string(i) + ": 12.5 V" + ((i < 7) ? "\r\n" : "");
+	std::string column = "ab\ncd\nef\r\n\n";
+
+	TestDisplay runs(false);
+	TestDisplay chars(false);
+	for(std::string const & screen : { status, wrapped, table, column }) {
+		for(TestDisplay * display : { &runs, &chars })
+			display->display.CursorSetPosition(0, 0);
+
+		size_t transactions = runs.panel.mTransactions;
+		BOOST_REQUIRE(runs.display.Write(screen.data(), screen.size()) == int(screen.size()));
+		transactions = runs.panel.mTransactions - transactions;
+		for(char c : screen)
+			BOOST_REQUIRE(chars.display.PutChar(c));
+		BOOST_REQUIRE(runs.panel.SameImage(chars.panel));
+		BOOST_TEST_MESSAGE("full screen Write(): " << transactions << " transactions");
+		BOOST_REQUIRE(transactions <= 10);
+	}
+}
+
+// Frames of a ball bouncing over a striped floor, for the animation tests.
+static std::vector<Ssd1306AnimationEncoder::Frame> bouncing_ball(unsigned count)
+{
+	std::vector<Ssd1306AnimationEncoder::Frame> frames;
+	for(unsigned i = 0; i < count; ++i) {
+		Ssd1306AnimationEncoder::Frame frame(128 * 8, 0);
+		for(unsigned x = 0; x < 128; ++x)
+			frame[7 * 128 + x] = (x + i) % 8 < 4 ? 0xf0 : 0x00;
+		int cx = 8 + (i * 3) % 112;
+		int cy = 8 + abs(int(i % 40) - 20) * 2;
+		for(int y = cy - 6; y <= cy + 6; ++y)
+			for(int x = cx - 6; x <= cx + 6; ++x)
+				if((x - cx) * (x - cx) + (y - cy) * (y - cy) <= 36)
+					frame[(y / 8) * 128 + x] |= 1 << (y % 8);
+		frames.push_back(frame);
+	}
+	return frames;
+}
+
+BOOST_AUTO_TEST_CASE(ssd1306_animation)
+{
+	std::vector<Ssd1306AnimationEncoder::Frame> frames = bouncing_ball(60);
+	Ssd1306AnimationEncoder encoder(128, 8, 40);
+	for(auto const & frame : frames)
+		encoder.Add(frame);
+	std::vector<uint8_t> const & stream = encoder.Stream();
+	BOOST_TEST_MESSAGE("animation: " << 60 * 1024 << " bytes of frames in " << stream.size() << " bytes");
+	BOOST_REQUIRE(8 * stream.size() < 60 * 1024);
+
+	for(bool buffered : { false, true }) {
+		TestDisplay display(buffered);
+		display.display.Puts("text\r\n");
+		display.display.Clear();
+		BOOST_REQUIRE(display.display.Flush());
+		size_t bytes = display.panel.mBytes;
+
+		Ssd1306Animation animation(stream.data(), stream.size());
+		BOOST_REQUIRE(animation.IsValid());
+		BOOST_REQUIRE(animation.FrameCount() == 60);
+		BOOST_REQUIRE(animation.FramePeriodMsecs() == 40);
+		for(auto const & frame : frames) {
+			BOOST_REQUIRE(animation.DrawFrame(display.display));
+			BOOST_REQUIRE(display.display.Flush());
+			for(unsigned page = 0; page < 8; ++page)
+				BOOST_REQUIRE(!memcmp(display.panel.mRam[page], &frame[page * 128], 128));
+		}
+		BOOST_REQUIRE(!animation.DrawFrame(display.display));
+		BOOST_TEST_MESSAGE("animation " << (buffered ? "with shadow: " : "direct: ")
+				<< display.panel.mBytes - bytes << " bytes on the bus");
+
+		// text still goes to the cursor
+		display.display.CursorSetPosition(0, 0);
+		display.display.Puts("ab");
+		BOOST_REQUIRE(display.display.Flush());
+		BOOST_REQUIRE(!memcmp(display.panel.mRam[0], font_tama_mini02::dataptr + 5 * ('a' - ' '), 5));
+	}
+
+	// broken streams are rejected, or played up to where they break
+	TestDisplay display(false);
+	Ssd1306Animation truncated(stream.data(), stream.size() / 2);
+	unsigned played = 0;
+	while(truncated.DrawFrame(display.display))
+		++played;
+	BOOST_REQUIRE(played < 60);
+	std::vector<uint8_t> wrong(stream);
+	wrong[3] = 0;
+	BOOST_REQUIRE(!Ssd1306Animation(wrong.data(), wrong.size()).IsValid());
+
+	// the frame count does not wrap
+	Ssd1306AnimationEncoder longest(1, 1, 0xffff);
+	Ssd1306AnimationEncoder::Frame still(1, 0);
+	for(unsigned i = 0; i < Ssd1306AnimationEncoder::cMaxFrames; ++i)
+		BOOST_REQUIRE(longest.Add(still));
+	BOOST_REQUIRE(!longest.Add(still));
+	Ssd1306Animation full(longest.Stream().data(), longest.Stream().size());
+	BOOST_REQUIRE(full.FrameCount() == 0xffff);
+	BOOST_REQUIRE(full.FramePeriodMsecs() == 0xffff);
+	BOOST_REQUIRE(!Ssd1306Animation(stream.data(), 5).IsValid());
+}
+
+BOOST_AUTO_TEST_CASE(ssd1306_animation_pbm)
+{
+	TestDisplay display(false);
+	display.display.Clear();
+	display.display.Puts("PBM round trip\r\n0123456789");
+
+	char path[] = "/tmp/ssd1306_animationXXXXXX";
+	int fd = mkstemp(path);
+	BOOST_REQUIRE(fd >= 0);
+	close(fd);
+	BOOST_REQUIRE(display.panel.WritePbm(path));
+	Ssd1306AnimationEncoder encoder(128, 8, 100);
+	Ssd1306AnimationEncoder::Frame frame;
+	BOOST_REQUIRE(encoder.ReadPbm(path, frame));
+	unlink(path);
+	for(unsigned page = 0; page < 8; ++page)
+		BOOST_REQUIRE(!memcmp(display.panel.mRam[(display.panel.mStartLine / 8 + page) % 8], &frame[page * 128], 128));
+}
+
+BOOST_AUTO_TEST_CASE(ssd1306_gray_surface)
+{
+	TestDisplay display(true);
+	Ssd1306GraySurface<Ssd1306I2cDisplay> gray(display.display);
+
+	// four bars of the four levels, 32 x 40 pixels each from row 4 on
+	for(unsigned level = 0; level < 4; ++level)
+		gray.FillRect(32 * level, 4, 32, 40, level);
+	gray.DrawLine(0, 60, 127, 50, 2);
+	BOOST_REQUIRE(gray.GetPixel(40, 10) == 1);
+	BOOST_REQUIRE(gray.GetPixel(40, 3) == 0);
+	BOOST_REQUIRE(gray.GetPixel(127, 50) == 2);
+
+	// the average of the sub-frames is the level
+	static unsigned const cFrames = 400;
+	static unsigned on[4];
+	size_t bytes = display.panel.mBytes;
+	for(unsigned frame = 0; frame < cFrames; ++frame) {
+		BOOST_REQUIRE(gray.Refresh());
+		BOOST_REQUIRE(display.display.Flush());
+		for(unsigned level = 0; level < 4; ++level)
+			for(unsigned x = 32 * level; x < 32 * level + 32; ++x)
+				for(unsigned y = 4; y < 44; ++y)
+					on[level] += display.panel.Pixel(x, y);
+	}
+	bytes = display.panel.mBytes - bytes;
+	static double const expected[4] = { 0, 0.25, 0.5, 1 };
+	for(unsigned level = 0; level < 4; ++level) {
+		double duty = double(on[level]) / (cFrames * 32 * 40);
+		BOOST_TEST_MESSAGE("gray level " << level << ": " << duty << " on");
+		BOOST_REQUIRE(std::abs(duty - expected[level]) < 0.01);
+	}
+	BOOST_TEST_MESSAGE("gray sub-frames: " << bytes / cFrames << " bytes each");
+	BOOST_REQUIRE(bytes / cFrames < 700);
+
+	// black and white do not change between sub-frames
+	gray.Clear(3);
+	gray.FillRect(10, 10, 50, 20, 0);
+	BOOST_REQUIRE(gray.Refresh());
+	BOOST_REQUIRE(display.display.Flush());
+	bytes = display.panel.mBytes;
+	BOOST_REQUIRE(gray.Refresh());
+	BOOST_REQUIRE(display.display.Flush());
+	BOOST_REQUIRE(display.panel.mBytes == bytes);
+}
+
+// Two panels at 0x3c and 0x3d on one bus, and a clock that runs with the
+// bus at 400kHz.
+struct SharedBus {
+	Ssd1306Emulator panels[2] = { Ssd1306Emulator(0x3c), Ssd1306Emulator(0x3d) };
+	std::vector<uint8_t> addresses;
+
+	static bool Tx(void * context, uint8_t address, uint8_t const * buffer, size_t len)
+	{
+		SharedBus * bus = static_cast<SharedBus *>(context);
+		bus->addresses.push_back(address);
+		return Ssd1306Emulator::Tx(&bus->panels[address & 1], address, buffer, len);
+	}
+
+	static uint32_t Usecs(void * context)
+	{
+		SharedBus * bus = static_cast<SharedBus *>(context);
+		return uint32_t((bus->panels[0].mBusBits + bus->panels[1].mBusBits) * 10 / 4);
+	}
+};
+
+static void put_at(Ssd1306I2cDisplay & display, unsigned x, unsigned y, char const * text)
+{
+	display.CursorSetPosition(x, y);
+	display.Puts(text);
+}
+
+BOOST_AUTO_TEST_CASE(ssd1306_compositor)
+{
+	SharedBus bus;
+	uint8_t framebuffers[2][Ssd1306I2cDisplay::cFramebufferSize];
+	Ssd1306I2cDisplay big(NULL, Ssd1306Emulator::Sleep, &bus, SharedBus::Tx, Ssd1306Emulator::Rx,
+			font_tama_mini02::dataptr, false, framebuffers[0], 0x3c);
+	Ssd1306I2cDisplay small(NULL, Ssd1306Emulator::Sleep, &bus, SharedBus::Tx, Ssd1306Emulator::Rx,
+			font_tama_mini02::dataptr, false, framebuffers[1], 0x3d);
+	TestDisplay big_ref(true);
+	TestDisplay small_ref(true);
+	BOOST_REQUIRE(bus.panels[0].SameImage(big_ref.panel));
+	BOOST_REQUIRE(bus.panels[1].SameImage(small_ref.panel));
+
+	Ssd1306Compositor<2> compositor(SharedBus::Usecs, &bus);
+	BOOST_REQUIRE(compositor.Add(big) == 0);
+	BOOST_REQUIRE(compositor.Add(small) == 1);
+	BOOST_REQUIRE(compositor.Add(small) == -1);
+	BOOST_REQUIRE(!compositor.HasChanges());
+	BOOST_REQUIRE(!compositor.Step());
+
+	// a full screen on one display does not hold back a line on the other
+	uint32_t start = SharedBus::Usecs(&bus);
+	big.FillRect(0, 0, 128, 64, Ssd1306I2cDisplay::DrawInvert);
+	big.Flush();
+	put_at(small, 0, 0, "12.5 V");
+	small.Flush();
+	uint32_t greedy = SharedBus::Usecs(&bus) - start;
+
+	bus.addresses.clear();
+	big.FillRect(0, 0, 128, 64, Ssd1306I2cDisplay::DrawInvert);
+	put_at(small, 0, 0, "13.0 V");
+	// windows ride along with the data of each slice
+	size_t commands = bus.panels[0].mCommandTransactions + bus.panels[1].mCommandTransactions;
+	BOOST_REQUIRE(compositor.Flush());
+	BOOST_REQUIRE(bus.panels[0].mCommandTransactions + bus.panels[1].mCommandTransactions == commands);
+	BOOST_REQUIRE(!compositor.HasChanges());
+	BOOST_REQUIRE(bus.addresses.back() == 0x3c);
+	BOOST_REQUIRE(std::count(bus.addresses.begin(), bus.addresses.end(), 0x3d) > 0);
+	BOOST_TEST_MESSAGE("line next to a full screen: " << greedy << " us greedy, "
+			<< compositor.Stats(1).mLastUsecs << " us interleaved, full screen "
+			<< compositor.Stats(0).mLastUsecs << " us in " << compositor.Stats(0).mSlices << " slices");
+	BOOST_REQUIRE(compositor.Stats(0).mUpdates == 1);
+	BOOST_REQUIRE(compositor.Stats(1).mUpdates == 1);
+	BOOST_REQUIRE(compositor.Stats(0).mSlices == 8);
+	BOOST_REQUIRE(4 * compositor.Stats(1).mLastUsecs < greedy);
+	BOOST_REQUIRE(compositor.Stats(0).mLastUsecs > compositor.Stats(1).mLastUsecs);
+
+	// the same pictures as with Flush(), in small slices
+	Ssd1306Compositor<2> sliced(SharedBus::Usecs, &bus, 20);
+	sliced.Add(big);
+	sliced.Add(small);
+	big_ref.display.FillRect(0, 0, 128, 64, Ssd1306I2cDisplay::DrawInvert);
+	big_ref.display.FillRect(0, 0, 128, 64, Ssd1306I2cDisplay::DrawInvert);
+	put_at(small_ref.display, 0, 0, "13.0 V");
+	BOOST_REQUIRE(big_ref.display.Flush() && small_ref.display.Flush());
+	BOOST_REQUIRE(bus.panels[0].SameImage(big_ref.panel));
+	BOOST_REQUIRE(bus.panels[1].SameImage(small_ref.panel));
+	LfsrDefault16 lfsr;
+	commands = bus.panels[0].mCommandTransactions + bus.panels[1].mCommandTransactions;
+	for(unsigned i = 0; i < 200; ++i) {
+		Ssd1306I2cDisplay * displays[2] = { &big, &small };
+		TestDisplay * refs[2] = { &big_ref, &small_ref };
+		unsigned which = lfsr.Iterate(1);
+		int x = lfsr.Iterate(7), y = lfsr.Iterate(6), w = lfsr.Iterate(6), h = lfsr.Iterate(5);
+		displays[which]->FillRect(x, y, w, h, Ssd1306I2cDisplay::DrawInvert);
+		refs[which]->display.FillRect(x, y, w, h, Ssd1306I2cDisplay::DrawInvert);
+		if(lfsr.Iterate(3) == 0) {
+			put_at(*displays[which], x / 8, y / 8, "status");
+			put_at(refs[which]->display, x / 8, y / 8, "status");
+		}
+		if(lfsr.Iterate(2) == 0) {
+			sliced.Step();
+		} else if(lfsr.Iterate(2) == 0) {
+			BOOST_REQUIRE(sliced.Flush());
+			BOOST_REQUIRE(big_ref.display.Flush() && small_ref.display.Flush());
+			BOOST_REQUIRE(bus.panels[0].SameImage(big_ref.panel));
+			BOOST_REQUIRE(bus.panels[1].SameImage(small_ref.panel));
+		}
+	}
+	BOOST_REQUIRE(sliced.Stats(0).mSlices > sliced.Stats(0).mUpdates);
+	BOOST_REQUIRE(bus.panels[0].mCommandTransactions + bus.panels[1].mCommandTransactions == commands);
+	BOOST_REQUIRE(sliced.AverageUsecs(0) <= sliced.Stats(0).mMaxUsecs);
+	BOOST_REQUIRE(bus.panels[0].mErrors == 0 && bus.panels[1].mErrors == 0);
+}
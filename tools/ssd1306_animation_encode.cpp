@@ -0,0 +1,87 @@
+#include "ssd1306_animation_encoder.h"
+
+#include <cstdlib>
+
+// Encodes PBM frames, e.g. written by tests/ssd1306_emulator.h or any image
+// tool, into a stream for embedded_drivers::Ssd1306Animation:
+//
+//   ssd1306_animation_encode [-p period_ms] [-n name] out.{bin,h} frame.pbm...
+//
+// An output ending in .h is written as a C array `name` for the firmware.
+// A stream holds at most 65535 frames, of at most 65535 ms each.
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: ssd1306_animation_encode [-p period_ms] [-n name] out.{bin,h} frame.pbm...\n"
+			"  at most %u frames, period_ms up to %u\n",
+			Ssd1306AnimationEncoder::cMaxFrames, Ssd1306AnimationEncoder::cMaxPeriodMsecs);
+	exit(1);
+}
+
+int main(int argc, char ** argv)
+{
+	unsigned period = 100;
+	std::string name = "animation";
+	int arg = 1;
+	for(; arg + 1 < argc && argv[arg][0] == '-'; arg += 2) {
+		if(!strcmp(argv[arg], "-p"))
+			period = atoi(argv[arg + 1]);
+		else if(!strcmp(argv[arg], "-n"))
+			name = argv[arg + 1];
+		else
+			usage();
+	}
+	if(argc - arg < 2 || period > Ssd1306AnimationEncoder::cMaxPeriodMsecs)
+		usage();
+	std::string out = argv[arg++];
+
+	// the size of the first frame is the size of all
+	unsigned width = 0, height = 0;
+	FILE * file = fopen(argv[arg], "rb");
+	if(!file || fscanf(file, "P%*1d %u %u", &width, &height) != 2 || !width || width > 128
+			|| height % 8 || !height || height > 64) {
+		fprintf(stderr, "%s: need a PBM of up to 128x64 pixels, a multiple of 8 rows high\n", argv[arg]);
+		return 1;
+	}
+	fclose(file);
+
+	Ssd1306AnimationEncoder encoder(width, height / 8, period);
+	size_t raw = 0;
+	for(; arg < argc; ++arg) {
+		Ssd1306AnimationEncoder::Frame frame;
+		if(!encoder.ReadPbm(argv[arg], frame)) {
+			fprintf(stderr, "%s: can not read a %ux%u PBM\n", argv[arg], width, height);
+			return 1;
+		}
+		if(!encoder.Add(frame)) {
+			fprintf(stderr, "%s: more than %u frames\n", argv[arg], Ssd1306AnimationEncoder::cMaxFrames);
+			return 1;
+		}
+		raw += frame.size();
+	}
+	std::vector<uint8_t> const & stream = encoder.Stream();
+
+	file = fopen(out.c_str(), "wb");
+	if(!file) {
+		perror(out.c_str());
+		return 1;
+	}
+	if(out.size() > 2 && !out.compare(out.size() - 2, 2, ".h")) {
+		fprintf(file, "#pragma once\n\n#include <cstdint>\n\n");
+		fprintf(file, "// %zu frames of %ux%u, see embedded_drivers/ssd1306_animation.h\n",
+				raw / (width * height / 8), width, height);
+		fprintf(file, "static uint8_t const %s[%zu] = {", name.c_str(), stream.size());
+		for(size_t i = 0; i < stream.size(); ++i)
+			fprintf(file, "%s0x%02x,", (i % 12) ? " " : "\n\t", stream[i]);
+		fprintf(file, "\n};\n");
+	} else {
+		fwrite(stream.data(), 1, stream.size(), file);
+	}
+	if(fclose(file)) {
+		perror(out.c_str());
+		return 1;
+	}
+
+	printf("%zu bytes of frames encoded in %zu bytes\n", raw, stream.size());
+	return 0;
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "embedded_drivers/ssd1306_animation.h"
+
+#include <cassert>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Host side encoder of the frame streams of embedded_drivers::Ssd1306Animation.
+//
+// Frames are `width` x 8*`pages` pixels in the page layout of the SSD1306:
+// `pages` rows of `width` column bytes, the top pixel in the LSB. Width is
+// 1..128, pages 1..8, as the player and panel accept.
+class Ssd1306AnimationEncoder {
+public:
+	typedef std::vector<uint8_t> Frame;
+
+	// Spans of unchanged bytes up to this long are sent anyway,
+	// as a new span costs 3 bytes and a run header.
+	static const unsigned cMaxGap = 4;
+
+	// The header holds both as 16 bits.
+	static const unsigned cMaxPeriodMsecs = 0xffff;
+	static const unsigned cMaxFrames = 0xffff;
+
+	Ssd1306AnimationEncoder(unsigned width, unsigned pages, unsigned periodMsecs)
+		: mWidth(width)
+		, mPages(pages)
+		, mPrevious(width * pages, 0)
+		, mFrames(0)
+	{
+		assert(width >= 1 && width <= 128);
+		assert(pages >= 1 && pages <= 8);
+		assert(periodMsecs <= cMaxPeriodMsecs);
+		uint8_t const header[] = { 'S', 'A', embedded_drivers::Ssd1306Animation::cVersion,
+			uint8_t(width), uint8_t(pages), uint8_t(periodMsecs), uint8_t(periodMsecs >> 8), 0, 0 };
+		mStream.assign(header, header + sizeof(header));
+	}
+
+	// Appends the changes from the previous frame, or from a cleared
+	// screen for the first one. Returns false, leaving the stream as it
+	// is, once it holds cMaxFrames.
+	bool Add(Frame const & frame)
+	{
+		if(mFrames >= cMaxFrames)
+			return false;
+
+		for(unsigned page = 0; page < mPages; ++page) {
+			uint8_t const * now = &frame[page * mWidth];
+			uint8_t const * before = &mPrevious[page * mWidth];
+			unsigned col = 0;
+			while(col < mWidth) {
+				if(now[col] == before[col]) {
+					++col;
+					continue;
+				}
+				// extend over changes and short gaps
+				unsigned end = col + 1;
+				unsigned last = col;
+				while(end < mWidth && end - last <= cMaxGap) {
+					if(now[end] != before[end])
+						last = end;
+					++end;
+				}
+				AddSpan(page, col, now + col, last - col + 1);
+				col = last + 1;
+			}
+		}
+		mStream.push_back(0);
+		mPrevious = frame;
+		++mFrames;
+		mStream[7] = uint8_t(mFrames);
+		mStream[8] = uint8_t(mFrames >> 8);
+		return true;
+	}
+
+	std::vector<uint8_t> const & Stream(void) const
+	{
+		return mStream;
+	}
+
+	// Reads a PBM image (P1 or P4) of the encoder's size into `frame`.
+	bool ReadPbm(char const * path, Frame & frame) const
+	{
+		FILE * file = fopen(path, "rb");
+		if(!file)
+			return false;
+		char magic[3] = { 0 };
+		unsigned width, height;
+		bool ok = fscanf(file, "%2s", magic) == 1 && SkipComments(file)
+			&& fscanf(file, "%u", &width) == 1 && SkipComments(file)
+			&& fscanf(file, "%u", &height) == 1 && width == mWidth && height == 8 * mPages;
+		bool binary = !strcmp(magic, "P4");
+		ok = ok && (binary || !strcmp(magic, "P1"));
+		if(ok && binary)
+			fgetc(file);
+
+		frame.assign(mWidth * mPages, 0);
+		int byte = 0;
+		for(unsigned y = 0; ok && y < height; ++y) {
+			for(unsigned x = 0; ok && x < width; ++x) {
+				int bit;
+				if(binary) {
+					if(x % 8 == 0)
+						byte = fgetc(file);
+					ok = (byte != EOF);
+					bit = (byte >> (7 - x % 8)) & 1;
+				} else {
+					ok = fscanf(file, " %1d", &bit) == 1;
+				}
+				if(bit)
+					frame[(y / 8) * mWidth + x] |= 1 << (y % 8);
+			}
+		}
+		fclose(file);
+		return ok;
+	}
+
+private:
+	unsigned const mWidth;
+	unsigned const mPages;
+	Frame mPrevious;
+	unsigned mFrames;
+	std::vector<uint8_t> mStream;
+
+	void AddSpan(unsigned page, unsigned col, uint8_t const * data, unsigned len)
+	{
+		mStream.push_back(page + 1);
+		mStream.push_back(col);
+		mStream.push_back(len - 1);
+
+		// repeats of at least 3 bytes, literals in between
+		unsigned literal = 0;
+		for(unsigned i = 0; i < len; ) {
+			unsigned repeat = 1;
+			while(i + repeat < len && data[i + repeat] == data[i] && repeat < 129)
+				++repeat;
+			if(repeat >= 3) {
+				AddLiterals(data + i - literal, literal);
+				literal = 0;
+				mStream.push_back(0x80 + repeat - 2);
+				mStream.push_back(data[i]);
+				i += repeat;
+			} else {
+				++literal;
+				++i;
+			}
+		}
+		AddLiterals(data + len - literal, literal);
+	}
+
+	void AddLiterals(uint8_t const * data, unsigned len)
+	{
+		while(len) {
+			unsigned count = (len < 128) ? len : 128;
+			mStream.push_back(count - 1);
+			mStream.insert(mStream.end(), data, data + count);
+			data += count;
+			len -= count;
+		}
+	}
+
+	static bool SkipComments(FILE * file)
+	{
+		int c;
+		while((c = fgetc(file)) != EOF) {
+			if(c == '#') {
+				while((c = fgetc(file)) != EOF && c != '\n')
+					;
+			} else if(!isspace(c)) {
+				ungetc(c, file);
+				return true;
+			}
+		}
+		return false;
+	}
+};